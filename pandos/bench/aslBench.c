@@ -0,0 +1,129 @@
+/**************************************************************************** 
+ * @file aslBench.c
+ *
+ * @brief
+ * Host-native benchmark of the Active Semaphore List (asl.c). Measures
+ * a semaphore lookup (headBlocked), a block/unblock pair (removeBlocked
+ * + insertBlocked) and the removal of an arbitrary blocked pcb
+ * (outBlocked + insertBlocked) for several numbers of active semaphores
+ * and of pcbs blocked on each of them. With the hashed ASL the per-op
+ * cost should stay flat as the number of active semaphores grows.
+ * Also compares two ways of waking every waiter of one semaphore (the
+ * pseudo-clock tick): one removeBlocked per waiter, or one
+ * removeAllBlocked + mergeProcQ for the whole queue.
+ *
+ * @authors Nicolas & Tran
+ ****************************************************************************/
+#include "../h/pcb.h"
+#include "../h/asl.h"
+#include "h/bench.h"
+
+HIDDEN int sems[BENCH_MAXPROC];        /* the semaphores pcbs block on */
+HIDDEN pcb_PTR procs[BENCH_MAXPROC];   /* the blocked pcbs */
+HIDDEN int semCnts[] = {1, 20, 200, 2000};
+HIDDEN int depths[] = {1, 8};          /* pcbs blocked on each semaphore */
+#define NSEMCNTS (sizeof(semCnts) / sizeof(semCnts[0]))
+#define NDEPTHS (sizeof(depths) / sizeof(depths[0]))
+
+/* 'active' semaphores with 'depth' pcbs blocked on each */
+HIDDEN void benchBlocked(int active, int depth){
+    volatile pcb_PTR sink;
+    pcb_PTR p;
+    int *sem;
+    int blocked = active * depth;
+    char op[40];
+    long i;
+
+    if (blocked > BENCH_MAXPROC){
+        return;
+    }
+    initPcbs();
+    initASL();
+    for (i = 0; i < blocked; i++){
+        procs[i] = allocPcb();
+        insertBlocked(&sems[i % active], procs[i]);
+    }
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        sink = headBlocked(&sems[benchRand() % active]);
+    }
+    sprintf(op, "headBlocked (depth %d)", depth);
+    benchReport("asl", op, "sems", active, BENCHOPS);
+
+    /* with depth 1 the descriptor is freed and reallocated every time */
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        sem = &sems[benchRand() % active];
+        p = removeBlocked(sem);
+        insertBlocked(sem, p);
+    }
+    sprintf(op, "remove+insertBlocked (depth %d)", depth);
+    benchReport("asl", op, "sems", active, BENCHOPS);
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = procs[benchRand() % blocked];
+        sem = p->p_semAdd;
+        outBlocked(p);
+        insertBlocked(sem, p);
+    }
+    sprintf(op, "out+insertBlocked (depth %d)", depth);
+    benchReport("asl", op, "sems", active, BENCHOPS);
+    (void) sink;
+}
+
+/* wake 'waiters' pcbs blocked on one semaphore, with 200 other semaphores active */
+HIDDEN void benchWakeAll(int waiters){
+    pcb_PTR readyQ = mkEmptyProcQ();
+    pcb_PTR p;
+    int clockSem;
+    int woken;
+    long rounds = BENCHOPS / waiters;
+    long r;
+    int i;
+
+    initPcbs();
+    initASL();
+    for (i = 0; i < 200; i++){
+        insertBlocked(&sems[i], allocPcb());
+    }
+    for (i = 0; i < waiters; i++){
+        insertProcQ(&readyQ, allocPcb());
+    }
+
+    /* every round: block all the waiters, then wake them up one by one */
+    benchStart();
+    for (r = 0; r < rounds; r++){
+        while ((p = removeProcQ(&readyQ)) != NULL){
+            insertBlocked(&clockSem, p);
+        }
+        while (headBlocked(&clockSem) != NULL){
+            insertProcQ(&readyQ, removeBlocked(&clockSem));
+        }
+    }
+    benchReport("asl", "block+wake, one at a time", "waiters", waiters, rounds * waiters);
+
+    /* same, but wake the whole queue at once */
+    benchStart();
+    for (r = 0; r < rounds; r++){
+        while ((p = removeProcQ(&readyQ)) != NULL){
+            insertBlocked(&clockSem, p);
+        }
+        mergeProcQ(&readyQ, removeAllBlocked(&clockSem, &woken));
+    }
+    benchReport("asl", "block+wake, removeAllBlocked", "waiters", waiters, rounds * waiters);
+}
+
+void aslBench(){
+    unsigned int s, d;
+
+    for (d = 0; d < NDEPTHS; d++){
+        for (s = 0; s < NSEMCNTS; s++){
+            benchBlocked(semCnts[s], depths[d]);
+        }
+    }
+    benchWakeAll(1);
+    benchWakeAll(16);
+    benchWakeAll(256);
+}
@@ -0,0 +1,18 @@
+#ifndef BENCH
+#define BENCH
+
+/**************************************************************************** 
+ * Nicolas & Tran
+ * Shared helpers of the host-native queue manager benchmark suite.
+ ****************************************************************************/
+
+#define BENCHOPS 2000000    /* timed operations per measurement */
+
+extern void benchStart();                                  /* start the clock */
+extern void benchReport(char *group, char *op, char *what, int size, long ops); /* stop the clock and print ns/op */
+extern unsigned int benchRand();                           /* cheap LCG, for scattered access orders */
+
+extern void pcbBench();     /* allocPcb/freePcb, process queues, process trees */
+extern void aslBench();     /* insertBlocked/removeBlocked/outBlocked/headBlocked */
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HOSTSHIM
+#define HOSTSHIM
+
+/**************************************************************************** 
+ * Nicolas & Tran
+ * Host shim for building the Phase 1 queue manager natively (x86-64 gcc).
+ *
+ * Force-included (gcc -include) ahead of pcb.c/asl.c. It pulls in the real
+ * const.h, widens the pool limits so the benchmarks can run with thousands
+ * of pcbs/semaphores, and only then pulls in types.h. The include guards
+ * make the modules' own #include "../h/const.h" lines no-ops afterwards.
+ * The host C headers are pulled in first so that they cannot redefine the
+ * kernel's NULL (0xFFFFFFFF) behind the modules' back.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#undef NULL
+#include "../../h/const.h"
+
+#undef MAXPROC
+#define MAXPROC BENCH_MAXPROC
+
+#undef ASLHASHSIZE
+#define ASLHASHSIZE BENCH_MAXPROC
+
+#include "../../h/types.h"
+
+#endif
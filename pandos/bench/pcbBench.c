@@ -0,0 +1,103 @@
+/**************************************************************************** 
+ * @file pcbBench.c
+ *
+ * @brief
+ * Host-native benchmark of the pcb free list, process queues and process
+ * trees (pcb.c). Queue and tree operations are measured at several
+ * sizes: the O(1) operations (insertProcQ/removeProcQ, outProcQ,
+ * insertChild/removeChild, outChild) should cost the same at every size.
+ *
+ * @authors Nicolas & Tran
+ ****************************************************************************/
+#include "../h/pcb.h"
+#include "h/bench.h"
+
+HIDDEN pcb_PTR procs[BENCH_MAXPROC];   /* pcbs taken off the free list */
+HIDDEN int sizes[] = {1, 16, 256, BENCH_MAXPROC - 1};
+#define NSIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+/* allocPcb/freePcb pair, with 'live' pcbs already allocated */
+HIDDEN void benchFreeList(int live){
+    pcb_PTR p;
+    long i;
+
+    initPcbs();
+    for (i = 0; i < live; i++){
+        procs[i] = allocPcb();
+    }
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = allocPcb();
+        freePcb(p);
+    }
+    benchReport("pcb", "allocPcb+freePcb", "live", live, BENCHOPS);
+}
+
+/* rotate a queue of 'len' pcbs; pull a scattered member out and back in */
+HIDDEN void benchProcQ(int len){
+    pcb_PTR tp = mkEmptyProcQ();
+    pcb_PTR p;
+    long i;
+
+    initPcbs();
+    for (i = 0; i < len; i++){
+        procs[i] = allocPcb();
+        insertProcQ(&tp, procs[i]);
+    }
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = removeProcQ(&tp);
+        insertProcQ(&tp, p);
+    }
+    benchReport("pcb", "removeProcQ+insertProcQ", "len", len, BENCHOPS);
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = outProcQ(&tp, procs[benchRand() % len]);
+        insertProcQ(&tp, p);
+    }
+    benchReport("pcb", "outProcQ+insertProcQ", "len", len, BENCHOPS);
+}
+
+/* a parent with 'kids' children; remove/out a child and give it back */
+HIDDEN void benchChild(int kids){
+    pcb_PTR prnt;
+    pcb_PTR p;
+    long i;
+
+    initPcbs();
+    prnt = allocPcb();
+    for (i = 0; i < kids; i++){
+        procs[i] = allocPcb();
+        insertChild(prnt, procs[i]);
+    }
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = removeChild(prnt);
+        insertChild(prnt, p);
+    }
+    benchReport("pcb", "removeChild+insertChild", "kids", kids, BENCHOPS);
+
+    benchStart();
+    for (i = 0; i < BENCHOPS; i++){
+        p = outChild(procs[benchRand() % kids]);
+        insertChild(prnt, p);
+    }
+    benchReport("pcb", "outChild+insertChild", "kids", kids, BENCHOPS);
+}
+
+void pcbBench(){
+    unsigned int s;
+
+    for (s = 0; s < NSIZES; s++){
+        benchFreeList(sizes[s]);
+    }
+    for (s = 0; s < NSIZES; s++){
+        benchProcQ(sizes[s]);
+    }
+    for (s = 0; s < NSIZES; s++){
+        benchChild(sizes[s]);
+    }
+}
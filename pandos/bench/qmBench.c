@@ -0,0 +1,66 @@
+/**************************************************************************** 
+ * @file qmBench.c
+ *
+ * @brief
+ * Driver of the host-native queue manager benchmark suite. Runs the pcb
+ * (pcbBench.c) and ASL (aslBench.c) groups, or only the groups named on
+ * the command line ("pcb", "asl"), and prints one ns/op line per
+ * operation and size:
+ *
+ *     group  operation                     size-label=N   ns/op
+ *
+ * The modules under test are built with the native compiler against
+ * h/hostShim.h (see the Makefile), so a data structure change can be
+ * measured in seconds instead of in emulator runs.
+ *
+ * @authors Nicolas & Tran
+ ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "h/bench.h"
+
+HIDDEN struct timespec benchT0;     /* start of the current measurement */
+HIDDEN unsigned int benchSeed = 1;  /* state of benchRand() */
+
+void benchStart(){
+    clock_gettime(CLOCK_MONOTONIC, &benchT0);
+}
+
+void benchReport(char *group, char *op, char *what, int size, long ops){
+    struct timespec end;
+    double ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = (end.tv_sec - benchT0.tv_sec) * 1e9 + (end.tv_nsec - benchT0.tv_nsec);
+    printf("%-4s %-30s %8s=%-5d %8.1f ns/op\n", group, op, what, size, ns / ops);
+}
+
+unsigned int benchRand(){
+    benchSeed = benchSeed * 1103515245 + 12345;
+    return benchSeed >> 8;
+}
+
+int main(int argc, char *argv[]){
+    int i;
+
+    if (argc == 1){
+        pcbBench();
+        aslBench();
+        return 0;
+    }
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "pcb") == 0){
+            pcbBench();
+        }
+        else if (strcmp(argv[i], "asl") == 0){
+            aslBench();
+        }
+        else{
+            fprintf(stderr, "usage: %s [pcb] [asl]\n", argv[0]);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -13,8 +13,12 @@
 
 int insertBlocked(int *semAdd, pcb_PTR p);
 pcb_PTR removeBlocked(int *semAdd);
+pcb_PTR removeAllBlocked(int *semAdd, int *count);
 pcb_PTR outBlocked(pcb_PTR p);
 pcb_PTR headBlocked(int *semAdd);
 void initASL();
+void initASLPool(semd_PTR pool, int count, semd_PTR *buckets, int bucketCnt);
+void growASLPool(semd_PTR pool, int count);
+int freeSemdCnt();
 
 #endif
\ No newline at end of file
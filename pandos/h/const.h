@@ -8,11 +8,12 @@
 /* Hardware & software constants */
 #define PAGESIZE		  4096			/* page size in bytes	*/
 #define WORDLEN			  4				  /* word size in bytes	*/
-#define MAXPROC 20 
+#define MAXPROC 20                /* pcbs in the static (fallback) pool; minimum boot-time capacity */
+#define ASLHASHSIZE   32          /* ASL hash buckets of the static pool (power of 2, >= MAXPROC) */
 #define MAXPAGES      32
 #define MAXUPROCS 8
 #define MAX_FREE_POOL 9
-#define SWAP_POOL_CAP (MAXUPROCS * 2)
+#define SWAP_POOL_CAP (MAXUPROCS * 2) /* swap pool frames at POOLBASEADDR (phase5 adds the free RAM above the kernel pools at boot) */
 #define STACKSIZE 499
 
 
@@ -148,6 +149,8 @@
 #define SYS16 16
 #define SYS17 17
 #define SYS18 18
+#define SYS21 21 /*GETCPUSTATS - per-process CPU accounting (19/20 are kept for PSEMVIRT/VSEMVIRT)*/
+#define SYS22 22 /*DISKSYNC - write the dirty disk sectors of the block cache back*/
 
 
 #define TLBS              3
@@ -206,6 +209,176 @@
 #define INTIMER  100000UL     
 #define PLT_HIGHEST_VAL   0xFFFFFFFFUL
 
+/* Scheduling policy, chosen at build time (make SCHED=SCHED_MLFQ) */
+#define SCHED_RR    0        /* round-robin over one ready queue, TIMESLICE quantum */
+#define SCHED_MLFQ  1        /* multi-level feedback queue */
+#ifndef SCHEDPOLICY
+#define SCHEDPOLICY SCHED_RR
+#endif
+#define MLFQLEVELS      3    /* ready queues; level l runs with a TIMESLICE << l quantum */
+#define MLFQBOOSTTICKS  10   /* pseudo-clock ticks (100ms each) between priority boosts */
+#if SCHEDPOLICY == SCHED_MLFQ
+#define READYLEVELS MLFQLEVELS
+#else
+#define READYLEVELS 1
+#endif
+
+/* Tickless idle: when nothing is ready, program the interval timer for the earliest real 
+   pseudo-clock deadline (or leave it off) instead of taking a tick every 100ms (make TICKLESS=0 to disable) */
+#ifndef TICKLESS
+#define TICKLESS    1
+#endif
+#define CLOCKNEXTTICK   0    /* SYS7 a1: wake at the next 100ms tick (plain SYS7) */
+
+/* Swap pool page replacement policy (pageRepl.c), chosen at build time (make PAGEREPL=REPL_CLOCK) */
+#define REPL_FIFO     0      /* round-robin cursor, free frames first */
+#define REPL_CLOCK    1      /* second chance: the cursor clears referenced pages and skips them once */
+#define REPL_AGING    2      /* evict the page with the lowest aged reference history */
+#define REPL_WSCLOCK  3      /* clock over the working set: evict pages unreferenced for WSTAU */
+#ifndef PAGEREPL
+#define PAGEREPL      REPL_FIFO
+#endif
+#define REFSAMPLEPERIOD 100000     /* Aging/WSClock: sample the reference bits at most every 100ms */
+#define WSTAU           500000     /* WSClock: working set window (0.5s) */
+#define AGEMSB          0x80000000 /* Aging: bit shifted in for a page referenced since the last sample */
+#define PFN_MASK        0xFFFFF000 /* physical frame address bits of entryLO */
+#define TLBMODEXC       1          /* TLB-Modification: store to a page mapped clean (D bit off) */
+
+/* Swap pool frame quotas (pageRepl.c): global replacement (any victim) or local (a u-proc at its
+   quota replaces its own pages), make REPLSCOPE=REPL_LOCAL QUOTAMIN=2 QUOTAMAX=0 */
+#define REPL_GLOBAL   0
+#define REPL_LOCAL    1
+#ifndef REPLSCOPE
+#define REPLSCOPE     REPL_GLOBAL
+#endif
+#ifndef QUOTAMIN
+#define QUOTAMIN      2      /* frames a u-proc keeps however hungry the others are */
+#endif
+#ifndef QUOTAMAX
+#define QUOTAMAX      0      /* most frames a u-proc may hold (0 = no limit but the pool) */
+#endif
+#define SCOPE_OWN       0    /* victim scopes tried by repl_victim(): the faulting u-proc's own pages */
+#define SCOPE_OVERQUOTA 1    /* pages of u-procs over their quota */
+#define SCOPE_ABOVEMIN  2    /* pages of u-procs above QUOTAMIN */
+#define SCOPE_ANY       3    /* any page */
+
+/* Page cleaner daemon (pageCleaner.c): 1 (on) or 0 (the Pager writes victims back itself) */
+#ifndef PAGECLEANER
+#define PAGECLEANER     1
+#endif
+#define CLEANRESERVE    4          /* swap pool frames kept free or clean */
+#define CLEANERSTACKPG  2          /* daemon stack: this many pages below RAMTOP */
+#define VMLATBUCKETS    8          /* fault latency histogram: < 1ms, < 2ms, ... < 64ms, longer */
+#define VMLATUNIT       1000       /* width of the first histogram bucket (1ms) */
+
+/* Reclaim list (pageRepl.c): clean pages unmapped ahead of reuse, so a fault on them needs no flash
+   read, make RECLAIMTARGET=n (0 = off: pages are evicted only when their frame is needed) */
+#ifndef RECLAIMTARGET
+#define RECLAIMTARGET   2          /* swap pool frames kept free or on the reclaim list */
+#endif
+
+/* Zero-fill-on-demand (vmSupport.c): pages outside a u-proc's flash image (the stack page, and the
+   pages past the end of .text/.data given by the .aout header) are zeroed on their first fault instead
+   of read from flash, make ZEROFILL=0 to read every page */
+#ifndef ZEROFILL
+#define ZEROFILL        1
+#endif
+#define ZEROFILL_BIT    0x00000001 /* software bit of entryLO (below G, ignored by the TLB): zero-fill page */
+#define AOUT_TEXT_OFFSET 4         /* .aout header (first words of page 0): .text offset in the image */
+#define AOUT_TEXT_FILESZ 5         /* .text size in the image */
+#define AOUT_DATA_OFFSET 8         /* .data offset in the image */
+#define AOUT_DATA_FILESZ 9         /* .data size in the image (.bss is not in it) */
+
+/* Striped swap space (swapSpace.c): 1 (dirty pages are written back to a swap slot on the least busy
+   flash device) or 0 (to their own flash image) */
+#ifndef STRIPESWAP
+#define STRIPESWAP      1
+#endif
+#ifndef SWAPSLOTS
+#define SWAPSLOTS       64         /* swap slots at the top of each flash device */
+#endif
+#define SWAPLOC(dev, block)  (((dev) << 16) | (block)) /* flash location of a page */
+#define SWAPLOC_DEV(loc)     ((loc) >> 16)
+#define SWAPLOC_BLOCK(loc)   ((loc) & 0xFFFF)
+
+/* Disk request scheduling for SYS14/SYS15 (diskSched.c), make DISKSCHED=DISK_FIFO|DISK_CLOOK */
+#define DISK_FIFO     0      /* arrival order */
+#define DISK_CLOOK    1      /* C-LOOK elevator by cylinder */
+#ifndef DISKSCHED
+#define DISKSCHED     DISK_CLOOK
+#endif
+#define DISKQLEN      16     /* request slots per disk (one per u-proc, plus daemons) */
+#define DR_FREE       0      /* request slot states */
+#define DR_WAITING    1
+#define DR_DISPATCHED 2
+#ifndef SEEKELIDE
+#define SEEKELIDE     1      /* skip the SEEK when the head is known to be on the cylinder (make SEEKELIDE=0) */
+#endif
+
+/* Disk block cache (diskCache.c): DISKCACHE 4KB sectors kept in frames after the DMA buffers, LRU,
+   written back by the flush daemon or SYS22, make DISKCACHE=0 to send every SYS14/SYS15 to the disk */
+#ifndef DISKCACHE
+#define DISKCACHE     8      /* cache entries (frames) */
+#endif
+#define DCACHESLOTS   ((DISKCACHE > 0) ? DISKCACHE : 1) /* size of the entry table */
+#define DISKFLUSHTIME 500000 /* the daemon writes dirty sectors back this long (0.5s) after the first store */
+#define DISKFLUSHSTACKPG 3   /* daemon stack: this many pages below RAMTOP */
+#ifndef DISKREADAHEAD
+#define DISKREADAHEAD 4      /* sectors read ahead of a sequential SYS15 stream (0 = off), at most DISKCACHE/2 */
+#endif
+#define DISKRAQLEN    16     /* read-ahead requests waiting for the daemon */
+#define DISKRASTACKPG 4      /* read-ahead daemon stack: this many pages below RAMTOP */
+
+/* Nucleus fast path for soft page faults (vmSupport.c tlb_fast_path()): 1 (on) or 0 (every TLB
+   exception is passed up to the Pager) */
+#ifndef FASTPATH
+#define FASTPATH        1
+#endif
+
+/* Read-ahead on page faults: largest window (pages loaded after the missing one), 0 = off */
+#ifndef READAHEAD
+#define READAHEAD       8
+#endif
+
+/* Kernel trace ring (trace.c) - compiled out unless built with make TRACE=1 */
+#ifndef TRACE
+#define TRACE       0
+#endif
+#define TRACESIZE     1024   /* records kept in the ring (the oldest are overwritten) */
+#define TRACEPRINTER  7      /* printer the ring is dumped to (print7.umps) at HALT/PANIC */
+#define TR_SWITCH     1      /* context switch:         a = pcb,       b = ready queue level */
+#define TR_SYSCALL    2      /* Nucleus syscall entry:  a = SYS number, b = pcb */
+#define TR_SYSRET     3      /* Nucleus syscall exit:   a = SYS number, b = pcb */
+#define TR_SUPSYS     4      /* support syscall entry:  a = SYS number, b = asid */
+#define TR_SUPRET     5      /* support syscall exit:   a = SYS number, b = asid */
+#define TR_INTR       6      /* interrupt:              a = line,       b = device */
+#define TR_PGFAULT    7      /* page fault:             a = asid,       b = missing page */
+#define TR_EVICT      8      /* page eviction:          a = victim asid, b = victim page */
+#define TR_BLOCK      9      /* block on a semaphore:   a = semAdd,     b = pcb */
+#define TR_UNBLOCK    10     /* unblock:                a = semAdd,     b = pcb */
+#define TR_WAKEALL    11     /* pseudo-clock wake-up:   a = semAdd,     b = processes woken */
+#define TR_REFAULT    12     /* resident page refault:  a = asid,       b = page */
+#define TR_VMSTATS    13     /* pager totals at the end: a = faults,    b = evictions */
+#define TR_VMWRITES   14     /* pager totals at the end: a = write-backs, b = refaults */
+#define TR_VMLAT      15     /* fault latency histogram: a = bucket,     b = faults */
+#define TR_VMREADAHEAD 16    /* pager totals at the end: a = pages read ahead, b = faults */
+#define TR_VMASID     17     /* hard faults per u-proc at the end: a = asid, b = faults */
+#define TR_RECLAIM    18     /* soft fault on the reclaim list: a = asid, b = page */
+#define TR_VMASIDSOFT 19     /* soft faults per u-proc at the end: a = asid, b = soft faults */
+#define TR_VMRECLAIM  20     /* pager totals at the end: a = reclaim-list soft faults, b = faults */
+#define TR_ZEROFILL   21     /* zero-fill page fault:   a = asid,       b = page */
+#define TR_VMZEROFILL 22     /* pager totals at the end: a = zero-filled pages, b = faults */
+#define TR_FASTFAULT  23     /* soft fault resolved in the Nucleus: a = asid, b = page */
+#define TR_VMFASTPATH 24     /* soft faults at the end, Nucleus fast path: a = faults, b = mean time (us) */
+#define TR_VMSLOWSOFT 25     /* soft faults at the end, passed up to the Pager: a = faults, b = mean time (us) */
+#define TR_VMSWAPDEV  26     /* write-backs per flash device at the end: a = device, b = pages */
+#define TR_DISKSTATS  27     /* disk requests at the end: a = disk, b = requests served */
+#define TR_DISKSEEK   28     /* disk head travel at the end: a = disk, b = mean seek distance (cylinders) */
+#define TR_DISKELIDE  29     /* SEEKs at the end: a = disk, b = seeks left out (ds_seeks in debug_fxn) */
+#define TR_DCACHEHIT  30     /* block cache at the end: a = disk, b = hits */
+#define TR_DCACHEMISS 31     /* block cache at the end: a = disk, b = misses */
+#define TR_DCACHERA   32     /* block cache at the end: a = disk, b = sectors read ahead */
+
 /* Phase 3 Constants*/
 #define FLASHADDRSHIFT 8
 #define VPN_MASK 0xFFFFF000
@@ -261,6 +434,27 @@
 
 #define DISKSTART (FRAMEADDRSHIFT + (PAGESIZE * SWAP_POOL_CAP)) /*disk dma buffers placed after swap pool (for now)*/
 #define FLASHSTART (DISKSTART + (DEV_UNITS * PAGESIZE)) /*flash dma buffers after disk buffers*/
+#define DCACHESTART (FLASHSTART + (DEV_UNITS * PAGESIZE)) /*disk block cache frames after the flash buffers*/
+
+/* Nucleus pcb & semaphore descriptor pools - sized at boot from the installed RAM (initial.c) */
+#define KERNPOOLSTART (DCACHESTART + (DISKCACHE * PAGESIZE)) /*pools carved right after the block cache frames*/
+#define KERNSTACKPAGES 8          /*pages kept free below RAMTOP for the test/daemon stacks*/
+#ifndef POOLRAMDIV
+#define POOLRAMDIV     16         /*the pools use at most 1/POOLRAMDIV of the installed RAM (make POOLRAMDIV=n)*/
+#endif
+#ifndef MAXPROCCAP
+#define MAXPROCCAP     1024       /*upper bound on the pool capacity, however large RAM is (make MAXPROCCAP=n)*/
+#endif
+
+/* debug_fxn() ids of the boot-time and end of run reports (breakpoint on debug_fxn, read a0-a3) */
+#define DBG_POOLCAP    1          /*initial.c: a1 = procCap, a2 = semd hash buckets, a3 = POOLRAMDIV*/
+#define DBG_SWAPCAP    2          /*vmSupport.c: a1 = swapPoolCap, a2 = SWAP_POOL_CAP, a3 = frames added*/
+#define DBG_VMSTATS    3          /*initProc.c: a1 = hard faults, a2 = refaults, a3 = evictions*/
+#define DBG_CLEANER    4          /*initProc.c: a1 = pages cleaned, a2 = write-backs, a3 = worst fault latency*/
+#define DBG_FASTPATH   5          /*initProc.c: a1 = Nucleus soft faults, a2 = Pager soft faults, a3 = Nucleus time*/
+#define DBG_DISKSCHED  6          /*initProc.c, per disk: a1 = disk, a2 = requests, a3 = seek distance (ds_queued in diskStats)*/
+#define DBG_SEEKELIDE  7          /*initProc.c, per disk: a1 = disk, a2 = SEEKs issued, a3 = SEEKs left out*/
+#define DBG_DCACHE     8          /*initProc.c, per disk: a1 = disk, a2 = cache hits, a3 = misses (ds_writebacks in diskStats)*/
 
 #define BLOCKS_4KB 1024
 #define HEADMASK 0x0000FF00
@@ -14,6 +14,7 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
 void disk_get(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_struct); /*sys15 - disk READ*/
 void flash_put(memaddr *logicalAddr, int flashNo, int blockNo, support_t *support_struct); /*sys16 - flash WRITE*/
 void flash_get(memaddr *logicalAddr, int flashNo, int blockNo, support_t *support_struct); /*sys17 - flash READ*/
+int disk_io(int diskNo, int sectNo, int command, memaddr buffer); /*one disk transfer straight to/from a kernel frame*/
 void flashOperation(memaddr *logicalAddr, int flashNo, int blockNo, int operation, support_t *support_struct); /*Helper method for flash_get and flash_put*/
  
 
@@ -0,0 +1,18 @@
+/****************************************************************************
+ * Nicolas & Tran
+ * Declaration File for diskCache.c module (disk block cache)
+ *
+ ****************************************************************************/
+#ifndef DISKCACHEH
+#define DISKCACHEH
+#include "../h/types.h"
+#include "../h/const.h"
+
+void initDiskCache(); /*empty the cache, launch the flush and read-ahead daemons*/
+int dcache_get(int asid, int diskNo, int sectNo, memaddr *dest); /*SYS15 through the cache*/
+int dcache_put(int diskNo, int sectNo, memaddr *src); /*SYS14 through the cache*/
+int dcache_sync(); /*write every dirty sector back*/
+void disk_sync(support_t *support_struct); /*sys22 - DISKSYNC*/
+void diskFlusher(); /*code for the flush daemon process*/
+void diskReadAhead(); /*code for the read-ahead daemon process*/
+#endif
@@ -0,0 +1,18 @@
+/****************************************************************************
+ * Nicolas & Tran
+ * Declaration File for diskSched.c module (disk request scheduling)
+ *
+ ****************************************************************************/
+#ifndef DISKSCHEDH
+#define DISKSCHEDH
+#include "../h/types.h"
+#include "../h/const.h"
+
+extern diskstats_t diskStats[DEV_UNITS]; /*per disk counters*/
+
+void initDiskSched(); /*empty the request queues*/
+void disk_acquire(int diskNo, int cyl); /*wait for the disk, in scheduling order*/
+void disk_release(int diskNo); /*hand the disk to the next request*/
+int disk_seek(int diskNo, int cyl); /*move the head to cyl, unless it is already there*/
+void disk_head_lost(int diskNo); /*forget the head position (error, reset)*/
+#endif
@@ -19,9 +19,13 @@ void terminateProcess(); /*SYS2*/
 void passeren(int *sem); /*SYS3*/
 pcb_PTR verhogen(int *sem); /*SYS4*/
 void waitForIO(int lineNum, int deviceNum, int readBool); /*SYS5*/
-void getCPUTime(state_t *savedState); /*SYS6*/
-void waitForClock(); /*SYS7*/
+void getCPUTime(state_t *savedState); /*SYS6 (phases 2-4)*/
+void getCPUTimeSplit(state_t *savedState, cpuacct_t *acct); /*SYS6 (phase5): CPU time split into the cpuacct_t buckets*/
+void waitForClock(void); /*SYS7 (phases 2-4)*/
+void waitForClockUntil(cpu_t deadline); /*SYS7 (phase5): wait for a tick, no later than TOD deadline*/
 void getSupportData(state_t *savedState); /*SYS8*/
+void chargeCpu(cpu_t *bucket); /*charge the time since quantum to currProc and one of its p_acct buckets*/
+void chargeRunTime(); /*on Nucleus entry: charge the time since quantum to currProc's own code*/
 cpu_t get_elapsed_time(); /*helper method to calculate elapsed time since process quantum began*/
 #define EXCODESHIFT   10
 
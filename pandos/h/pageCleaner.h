@@ -0,0 +1,19 @@
+/**************************************************************************** 
+ * Nicolas & Tran
+ * Declaration File for pageCleaner.c module
+ * 
+ ****************************************************************************/
+#ifndef PAGECLEANERH
+#define PAGECLEANERH
+
+#include "../h/types.h"
+#include "../h/const.h"
+
+extern int cleanerSema4;
+
+void initPageCleaner(); /*launch the page cleaner daemon*/
+void pageCleaner(); /*code for the page cleaner daemon process*/
+int cleaner_wanted(); /*the clean frame reserve is low and the daemon idle*/
+void cleaner_kick(); /*wake the daemon when the clean frame reserve runs low*/
+
+#endif
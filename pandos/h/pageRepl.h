@@ -0,0 +1,27 @@
+/**************************************************************************** 
+ * Nicolas & Tran
+ * Declaration File for pageRepl.c module (swap pool page replacement)
+ * 
+ ****************************************************************************/
+#ifndef PAGEREPLH
+#define PAGEREPLH
+#include "../h/types.h"
+#include "../h/const.h"
+
+extern swap_pool_t *swap_pool; /*swap pool table (vmSupport.c), sized at boot*/
+extern int swapPoolCap; /*number of swap pool frames*/
+
+void repl_init(); /*reset the policy state (cursor, sampling clock)*/
+int repl_victim(int asid); /*pick the swap pool frame to (re)use next for a page of asid*/
+int repl_clean_victim(int asid); /*same, but FREE instead of a dirty frame (read-ahead)*/
+void repl_assign(int frame, int asid); /*change the owner of a frame (FREE to free it), keeping resident set counts*/
+int repl_may_grow(int asid); /*asid is below its maximum (and, in local mode, its quota)*/
+int repl_resident(int asid); /*resident set size of asid*/
+void repl_loaded(int frame); /*a page was just loaded into frame*/
+void repl_fill_reclaim(); /*unmap clean pages ahead of reuse, onto the reclaim list*/
+void repl_reclaim(int frame); /*soft fault on a page on the reclaim list: map it again*/
+void repl_remap(int frame); /*refault or reclaim from the Nucleus (interrupts off)*/
+void repl_refault(int frame); /*the resident page in frame was referenced again after a reference sample*/
+void repl_sample(); /*periodic reference sampling (Aging, WSClock)*/
+int repl_next_dirty(); /*dirty frame closest to eviction, for the page cleaner daemon*/
+#endif
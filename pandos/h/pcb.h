@@ -15,6 +15,9 @@
 void freePcb (pcb_PTR p);
 pcb_PTR allocPcb ();
 void initPcbs ();
+void initPcbPool (pcb_PTR pool, int count);
+void growPcbPool (pcb_PTR pool, int count);
+int freePcbCnt ();
 
 pcb_PTR mkEmptyProcQ ();
 int emptyProcQ (pcb_PTR tp);
@@ -22,6 +25,7 @@ void insertProcQ (pcb_PTR *tp, pcb_PTR p);
 pcb_PTR removeProcQ (pcb_PTR *tp);
 pcb_PTR outProcQ (pcb_PTR *tp, pcb_PTR p);
 pcb_PTR headProcQ (pcb_PTR tp);
+void mergeProcQ (pcb_PTR *tp, pcb_PTR src);
 
 int emptyChild (pcb_PTR p);
 void insertChild (pcb_PTR prnt, pcb_PTR p);
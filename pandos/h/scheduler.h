@@ -8,5 +8,15 @@
  ****************************************************************************/
 extern volatile cpu_t quantum;
 extern void switchProcess();
+extern void initReadyQueues();
+extern void readyProc(pcb_PTR p);
+extern void readyProcQ(pcb_PTR tp);
+extern pcb_PTR unreadyProc(pcb_PTR p);
+extern void demoteProc(pcb_PTR p);
+extern void promoteProc(pcb_PTR p);
+extern void boostTick();
+extern void clockWaitNote(cpu_t deadline);
+extern void clockTickNote();
+extern void requestClockBy(cpu_t deadline);
 extern void copyState(state_PTR src, state_PTR dst);
 #endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+/****************************************************************************
+ * Nicolas & Tran
+ * Declaration File for swapSpace.c module (flash locations of non-resident pages)
+ *
+ ****************************************************************************/
+#ifndef SWAPSPACEH
+#define SWAPSPACEH
+#include "../h/types.h"
+#include "../h/const.h"
+
+void swap_init(); /*set up the swap areas, every page at home*/
+int swap_locate(int asid, int page_no); /*where a non-resident page is: SWAPLOC(device, block)*/
+int swap_alloc(int asid, int page_no); /*where to write a dirty page back*/
+void swap_free_page(int asid, int page_no); /*release the swap slot of a page*/
+unsigned int swap_user_blocks(int flashNo); /*blocks of a flash device left to SYS16/SYS17*/
+#endif
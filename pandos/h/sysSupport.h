@@ -9,6 +9,7 @@
 #include "../h/const.h"
 
 extern int devSema4_support[DEVICE_TYPES * DEV_UNITS];
+extern int devHolder[DEVICE_TYPES * DEV_UNITS]; /*asid of the u-proc holding each device semaphore in a SYS, FREE if none*/
 
 
 extern void sysSupportGenHandler();
@@ -18,6 +19,7 @@ void getTOD(state_PTR excState);
 void write_to_printer(char *virtualAddr, int len, support_t *support_struct);
 void write_to_terminal(char *virtualAddr, int len, support_t *support_struct);
 void read_from_terminal(char *virtualAddr, support_t *support_struct);
+void get_cpu_stats(cpuacct_t *virtualAddr, support_t *support_struct);
 void syscall_excp_handler(support_t *suppStruct, int syscall_num_requested);
 
 #endif
\ No newline at end of file
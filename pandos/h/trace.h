@@ -0,0 +1,23 @@
+#ifndef TRACEH
+#define TRACEH
+
+/**************************************************************************** 
+ * Nicolas & Tran
+ * Declaration file for the kernel trace ring module (trace.c)
+ * 
+ * Tracepoints are written TRACE_EVENT(type, a, b); they compile to nothing 
+ * unless the kernel is built with TRACE=1.
+ ****************************************************************************/
+#include "../h/const.h"
+#include "../h/types.h"
+
+#if TRACE
+#define TRACE_EVENT(type, a, b) traceEvent((type), (unsigned int) (a), (unsigned int) (b))
+#else
+#define TRACE_EVENT(type, a, b)
+#endif
+
+void traceEvent(unsigned int type, unsigned int a, unsigned int b); /*append one record to the ring*/
+void traceDump(); /*write the ring, oldest record first, to printer TRACEPRINTER*/
+
+#endif
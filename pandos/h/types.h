@@ -101,8 +101,69 @@ typedef struct swap_pool_t {
     int         asid;  
     int         pg_number;
     pte_entry_t *ownerEntry;  
+    int         dirty;     /* page written since it was read from flash (needs a write-back on eviction) */
+    int         busy;      /* in transit: a write-back or read is in progress (swap pool unlocked) */
+    int         dying;     /* its owner terminated while it was in transit: freed once the I/O is over */
+    int         waiters;   /* faults waiting for this frame to leave transit */
+    int         sema4;     /* semaphore the waiters block on */
+    unsigned int age;      /* Aging: reference history, AGEMSB = most recent sample */
+    cpu_t       lastUse;   /* WSClock: last time the page was seen referenced */
+    unsigned int reclaimSeq; /* page evicted but frame not reused yet: order it joined the reclaim list (0 = not on it) */
 } swap_pool_t;
 
+/* a disk request waiting for (or handed) its disk (diskSched.c) */
+typedef struct diskreq_t {
+    int          dr_state;  /* DR_FREE, DR_WAITING or DR_DISPATCHED */
+    int          dr_cyl;    /* cylinder the request seeks to */
+    unsigned int dr_seq;    /* arrival order on its disk */
+    int          dr_sema4;  /* the requester waits here for the disk */
+} diskreq_t;
+
+/* per disk counters (diskSched.c) */
+typedef struct diskstats_t {
+    unsigned int ds_requests; /* requests served (SYS14/SYS15) */
+    unsigned int ds_queued;   /* requests that had to wait for the disk */
+    unsigned int ds_seekDist; /* cylinders travelled by the head, summed over the requests */
+    unsigned int ds_seeks;    /* SEEK commands issued */
+    unsigned int ds_seekSkip; /* SEEKs left out, the head already on the cylinder */
+    unsigned int ds_hits;     /* SYS14/SYS15 served by the block cache */
+    unsigned int ds_misses;   /* SYS14/SYS15 that needed a cache entry for a new sector */
+    unsigned int ds_writebacks; /* dirty cache entries written to the disk */
+    unsigned int ds_readahead;  /* sectors read into the cache ahead of a sequential SYS15 stream */
+} diskstats_t;
+
+/* a 4KB disk sector held in the block cache (diskCache.c) */
+typedef struct dcache_t {
+    int          dc_disk;    /* disk of the sector, FREE for an empty entry */
+    int          dc_sector;  /* linear sector number */
+    int          dc_dirty;   /* newer than the disk; stays TRUE while being written back */
+    int          dc_busy;    /* in transit: being read, written back or copied */
+    int          dc_waiters; /* processes waiting for the entry to leave transit */
+    int          dc_sema4;   /* they wait here */
+    unsigned int dc_lastUse; /* LRU stamp */
+} dcache_t;
+
+/* pager counters (vmSupport.c) */
+typedef struct vmstats_t {
+    unsigned int vm_faults;    /* page faults that needed a flash read */
+    unsigned int vm_refaults;  /* soft faults on resident pages whose V bit was cleared for reference sampling */
+    unsigned int vm_evictions; /* pages evicted from the swap pool */
+    unsigned int vm_writebacks; /* evictions of dirty pages, written back to flash */
+    unsigned int vm_cleaned;   /* dirty pages written back ahead of time by the page cleaner */
+    unsigned int vm_readahead; /* pages loaded by read-ahead (no fault of their own) */
+    unsigned int vm_reclaims;  /* soft faults on evicted pages still on the reclaim list */
+    unsigned int vm_zerofills; /* faults on pages outside the flash image, served by zeroing a frame */
+    unsigned int vm_fastFaults; /* soft faults (refault, reclaim, first store) resolved by the Nucleus fast path */
+    cpu_t        vm_fastTime;  /* their total service time, Nucleus entry to LDST */
+    unsigned int vm_slowSoft;  /* soft faults resolved by the Pager after a pass up */
+    cpu_t        vm_slowSoftTime; /* their total service time, Nucleus entry to LDST */
+    unsigned int vm_asidFaults[MAXUPROCS + 1]; /* hard faults of each asid */
+    unsigned int vm_asidSoft[MAXUPROCS + 1];   /* soft faults (refaults and reclaims) of each asid */
+    unsigned int vm_swapDev[DEV_UNITS]; /* pages written back to each flash device */
+    cpu_t        vm_latMax;    /* longest page fault (hard faults, entry of the Pager to LDST) */
+    unsigned int vm_latHist[VMLATBUCKETS]; /* hard fault latency, bucket i: < VMLATUNIT << i */
+} vmstats_t;
+
 typedef struct support_t {
     int       sup_asid;            /* process Id (asid) */
     state_t   sup_exceptState[2];  /* stored except states */
@@ -111,9 +172,18 @@ typedef struct support_t {
     int sup_stackTLB[500]; /* the stack area for the process' TLB exception handler */
     int sup_stackGen[500]; /* the stack area for the process' general exception handler */
 	int privateSema4; /*Phase 5 - synchronization semaphore used for SYS18 Delay*/
+    cpu_t     sup_faultTOD;        /* Phase 5 - time the Nucleus took the last TLB exception (soft fault timing) */
 } support_t;
 
 
+/* per-process CPU accounting (microseconds); the buckets add up to p_time */
+typedef struct cpuacct_t {
+	cpu_t ca_user;         /* running its own code (user mode, or a kernel-mode process without support level) */
+	cpu_t ca_sys;          /* in the Nucleus, serving its SYSCALLs and pass ups */
+	cpu_t ca_intr;         /* in the Nucleus, serving interrupts that arrived while it was running */
+	cpu_t ca_support;      /* in its support level handlers (kernel mode, with a support structure) */
+} cpuacct_t;
+
 /* Process Control Block (PCB) type */
 typedef struct pcb_t {
 	/* Process queue fields */
@@ -130,7 +200,11 @@ typedef struct pcb_t {
 	/* Process status information */
     state_t p_s;           /* Processor state */
     cpu_t p_time;          /* CPU time used by the process */
+    cpuacct_t p_acct;      /* p_time split by where it was spent */
     int *p_semAdd;         /* Pointer to semaphore on which the process is blocked */
+    struct semd_t *p_semd; /* Pointer to the ASL descriptor of p_semAdd (NULL if not blocked) */
+    int p_prio;            /* MLFQ level (0 = highest), valid while p_boost is the current boost epoch */
+    unsigned int p_boost;  /* MLFQ boost epoch p_prio was set in */
 
     /* Support layer information */
     support_t *p_supportStruct; /* Pointer to support structure */
@@ -139,7 +213,7 @@ typedef struct pcb_t {
 
 typedef struct semd_t {
 
-struct semd_t *s_next;   /* next element on the ASL */
+struct semd_t *s_next;   /* next element in the same ASL hash bucket */
 int 		  *s_semAdd; /* pointer to the semaphore*/
 pcb_t 		   *s_procQ;  /* tail ptr to process queue */
 
@@ -152,6 +226,14 @@ typedef struct delayd_t {
 	support_t *d_supStruct;
 } delayd_t, *delayd_PTR;
 
+/* kernel trace ring record (trace.c) */
+typedef struct tracerec_t {
+	cpu_t t_tod;           /* STCK timestamp */
+	unsigned int t_type;   /* TR_* event */
+	unsigned int t_a;      /* event arguments, see TR_* in const.h */
+	unsigned int t_b;
+} tracerec_t;
+
 typedef int semaphore;
 
 #define	s_at	s_reg[0]
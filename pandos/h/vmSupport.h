@@ -9,10 +9,17 @@
 #include "../h/types.h"
 #include "../h/const.h"
 void initSwapStructs(); /*init swap pool, device semaphores + swap pool semaphore*/
-int find_frame_swapPool(); /*page replacement*/
+int find_frame_swapPool(); /*page replacement (phase5: takes the faulting asid)*/
+void swap_release_asid(int asid); /*free the swap pool frames of a terminating u-proc*/
 void update_tlb_handler(pte_entry_t *ptEntry); /*maintain TLB and page table consistency*/
 void flash_read_write(int deviceNum, int block_num, int op_type, int frame_dest); /*write or read to flash device (backing store)*/
+void frame_release(int frame); /*end the transit (busy) state of a swap pool frame, wake its waiters*/
+int frame_reap(int frame); /*free a frame whose owner terminated during its I/O*/
+memaddr swap_frame_addr(int frame); /*physical address of a swap pool frame*/
+unsigned int flash_io(int deviceNum, int block_num, int op_type, int frame_dest); /*flash operation without the program trap, returns device status*/
 void uTLB_RefillHandler();
+int tlb_fast_path(support_t *supp); /*Nucleus: resolve a soft page fault without passing it up*/
 void tlb_exception_handler();
-extern swap_pool_t swap_pool[SWAP_POOL_CAP]; /*declare swap pool*/
+extern vmstats_t vmStats; /*pager counters*/
+extern int semaphore_swapPool; /*swap pool semaphore*/
 #endif
\ No newline at end of file
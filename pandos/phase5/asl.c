@@ -4,14 +4,17 @@ Dr. Mikey Goldweber
 Written by: Nicolas & Tran
 
  This module manages the creation and release of semaphore descriptors  
- in two linked lists: the Active Semaphore List (ASL) and the semdFree list.  
+ in two structures: the Active Semaphore List (ASL) and the semdFree list.  
  The ASL keeps track of semaphores that currently have at least one process  
  waiting in their associated queue, while the semdFree list stores available  
  semaphore descriptors that are not in use.  
  
- Both lists are implemented as NULL-terminated, singly linked lists.  
- Additionally, they function like a stack, where semaphores are added  
- and removed from the front of the list.  
+ The ASL is implemented as a hash table keyed on the semaphore address 
+ (s_semAdd). Each bucket is a NULL-terminated, singly linked chain of 
+ descriptors taken from the static semdTable pool, so finding the descriptor 
+ of a semaphore costs O(1) on average instead of a walk over every active 
+ semaphore. The semdFree list is a NULL-terminated, singly linked list that 
+ functions like a stack, where descriptors are added and removed from the front.  
 
 To view version history and changes:
     - Remote GitHub Repo: https://github.com/AtypicalAsian/CS372-OS-Project
@@ -22,12 +25,12 @@ To view version history and changes:
 #include "../h/asl.h"
 #include "../h/pcb.h"
 
-HIDDEN semd_PTR semd_h;             /*ptr to head of active semaphore list (ASL)*/
+HIDDEN semd_PTR *semd_h;            /*bucket heads of the active semaphore list (ASL) hash table*/
+HIDDEN unsigned int aslHashMask;    /*number of buckets - 1 (bucket count is a power of 2)*/
 HIDDEN semd_PTR semdFree_h;         /*ptr to head of free semaphore list*/
 
-#define MAXPROC_SEM (MAXPROC + 2)
-#define LARGEST_ADDR  0x0FFFFFFF
-#define SMALLEST_ADDR 0x00000000
+#define MAXPROC_SEM MAXPROC
+#define ASLHASH(semAdd) ((((memaddr) (semAdd)) >> 2) & aslHashMask) /*semaphores are word aligned, drop the 2 low bits*/
 
 /**************************************************************************** 
  *  freeSemaphore 
@@ -43,77 +46,95 @@ void freeSemaphore(semd_PTR sempahore){
 /**************************************************************************** 
  *  initASL
  *  Initialize the semdFree list to contain all the elements of the array static semd_t semdTable[MAXPROC_SEM]
- *  Init ASL to have dummy head and tail nodes
+ *  Init ASL to have all of its ASLHASHSIZE hash buckets empty
  *  This method will be only called once during data structure initialization
+ *  @note The Nucleus sizes its pool at boot with initASLPool() instead (see initPools() in initial.c);
+ *        this static pool is the fallback when RAM is too small for that
  *  params: None
  *  return: none 
  *****************************************************************************/
 void initASL(){
     static semd_t semdTable[MAXPROC_SEM];
+    static semd_PTR semdBuckets[ASLHASHSIZE];
 
+    initASLPool(semdTable, MAXPROC_SEM, semdBuckets, ASLHASHSIZE);
+}
+
+/**************************************************************************** 
+ *  initASLPool
+ *  Initialize the semdFree list to contain the count descriptors of the array pool
+ *  Init ASL to use the bucketCnt (a power of 2) heads of buckets, all empty
+ *  params: pointer to an array of descriptors, number of descriptors in the array,
+ *          array of bucket heads, number of bucket heads
+ *  return: none 
+ *****************************************************************************/
+void initASLPool(semd_PTR pool, int count, semd_PTR *buckets, int bucketCnt){
 
     /************ Init Free Semaphore List ************/
     semdFree_h = NULL;
-
-    int i;
-    for (i=0;i<MAXPROC_SEM;i++){
-        freeSemaphore(&semdTable[i]);
-    }
+    growASLPool(pool, count);
 
     /************ Init Active Semaphore List ************/
-    semd_PTR dummy_head = NULL;
-    semd_PTR dummy_tail = NULL;
-
-    /*remove first node from free semaphore list to make as dummy head node*/
-    dummy_head = semdFree_h;
-    semdFree_h = dummy_head->s_next;
-
-    /*remove second node from free semaphore list to make dummy tail node*/
-    dummy_tail = semdFree_h;
-    semdFree_h = dummy_tail->s_next;
+    semd_h = buckets;
+    aslHashMask = bucketCnt - 1;
 
+    /*NULL is not 0 on this machine, so every bucket has to be emptied explicitly*/
+    int i;
+    for (i=0;i<bucketCnt;i++){
+        semd_h[i] = NULL;
+    }
+}
 
-    /* Init active semaphore list with dummy nodes */
-    /* Init dummy nodes with smallest and largest memory address in 32-bit address to maintain sorted ASL */
-    dummy_tail->s_next = NULL;
-    dummy_tail->s_semAdd = (int*) LARGEST_ADDR; /*Largest possible address*/
-    dummy_head->s_next = dummy_tail;
-    dummy_head->s_semAdd = (int*) SMALLEST_ADDR; /*Smallest possible address*/
-
-    /* Set head of active semaphore list (ASL) */
-    semd_h = dummy_head;
+/**************************************************************************** 
+ *  growASLPool
+ *  Add the count descriptors of the array pool to the semdFree list
+ *  params: pointer to an array of descriptors, number of descriptors in the array
+ *  return: none 
+ *****************************************************************************/
+void growASLPool(semd_PTR pool, int count){
+    int i;
+    for (i=0;i<count;i++){
+        freeSemaphore(&pool[i]);
+    }
+}
 
+/**************************************************************************** 
+ *  freeSemdCnt
+ *  Count the descriptors on the semdFree list (for the stress tests: a leak shows up here)
+ *  params: none
+ *  return: number of free semaphore descriptors
+ *****************************************************************************/
+int freeSemdCnt(){
+    int count = 0;
+    semd_PTR s;
+    for (s = semdFree_h; s != NULL; s = s->s_next){
+        count++;
+    }
+    return count;
 }
 
 /****************************************************************************  
  *  search_semp  
- *  Searches the ASL for the semaphore descriptor whose address directly  
- *  precedes where semAdd should belong.  
+ *  Searches the hash bucket of semAdd for its semaphore descriptor.  
  *  
  *  params:  
  *      - int *semAdd: The memory address of the semaphore descriptor.  
  *  returns:  
- *      - Pointer to the preceding semaphore descriptor if found.  
- *      - If ASL is empty, returns NULL.  
+ *      - Pointer to the link (bucket head or the s_next field of the  
+ *        preceding descriptor) that points to the descriptor of semAdd.  
+ *      - If semAdd is not active, pointer to the NULL link that ends  
+ *        the bucket chain.  
  ****************************************************************************/  
  
-semd_PTR search_semp(int *semAdd) {
-    if (semd_h == NULL) return NULL;  /* ASL is empty */
-
-    semd_PTR prev = NULL;
-    semd_PTR curr = semd_h;  
-
-    /* Traverse the ASL to find the correct position */
-    while (curr != NULL && curr->s_semAdd < semAdd) {
-        /* Stop at tail dummy node */
-        if (curr->s_semAdd == (int*) LARGEST_ADDR) {
-            return prev;
-        }
-        prev = curr;
-        curr = curr->s_next;
+semd_PTR *search_semp(int *semAdd) {
+    semd_PTR *link = &semd_h[ASLHASH(semAdd)];
+
+    /* Walk the (short) bucket chain until we hit semAdd or the end of the chain */
+    while (*link != NULL && (*link)->s_semAdd != semAdd) {
+        link = &((*link)->s_next);
     }
 
-    return prev;  /* Return the node that precedes the target position */
+    return link;
 }
 
 
@@ -134,20 +155,15 @@ semd_PTR search_semp(int *semAdd) {
 int insertBlocked(int *semAdd, pcb_PTR p) {
     if (p == NULL) return TRUE;  
 
-    /* Find the position in the ASL */
-    semd_PTR prev_ptr = search_semp(semAdd);
-    semd_PTR curr_ptr;
-    
-    if (prev_ptr != NULL) {
-        curr_ptr = prev_ptr->s_next;
-    } else {
-        curr_ptr = NULL;
-    }
+    /* Find the link to the descriptor in semAdd's hash bucket */
+    semd_PTR *link = search_semp(semAdd);
+    semd_PTR curr_ptr = *link;
 
     /* If the semaphore exists, insert the process */
-    if (curr_ptr != NULL && curr_ptr->s_semAdd == semAdd) {
+    if (curr_ptr != NULL) {
         insertProcQ(&(curr_ptr->s_procQ), p);
         p->p_semAdd = semAdd;
+        p->p_semd = curr_ptr;
         return FALSE;
     }
 
@@ -163,15 +179,11 @@ int insertBlocked(int *semAdd, pcb_PTR p) {
     new_semd->s_procQ = mkEmptyProcQ();
     insertProcQ(&(new_semd->s_procQ), p);
     p->p_semAdd = semAdd;
+    p->p_semd = new_semd;
 
-    /* Link new semd into the ASL */
-    new_semd->s_next = curr_ptr;
-    
-    if (prev_ptr != NULL) {
-        prev_ptr->s_next = new_semd;
-    } else {
-        semd_h = new_semd;  /* Update head if inserting at the start */
-    }
+    /* Link new semd into its bucket (at the end of the chain, where search_semp stopped) */
+    new_semd->s_next = NULL;
+    *link = new_semd;
 
     return FALSE;
 }
@@ -191,17 +203,11 @@ int insertBlocked(int *semAdd, pcb_PTR p) {
  *  return: pointer to removed pcb. Otherwise, return NULL
  *****************************************************************************/
 pcb_PTR removeBlocked(int *semAdd) {
-    semd_PTR prev_ptr = search_semp(semAdd);
-    semd_PTR curr_ptr;
-
-    if (prev_ptr != NULL) {
-        curr_ptr = prev_ptr->s_next;
-    } else {
-        curr_ptr = NULL;
-    }
+    semd_PTR *link = search_semp(semAdd);
+    semd_PTR curr_ptr = *link;
 
     /* If the semaphore is not found, return NULL */
-    if (curr_ptr == NULL || curr_ptr->s_semAdd != semAdd) return NULL;
+    if (curr_ptr == NULL) return NULL;
 
     /* Remove the first PCB from the queue */
     pcb_PTR removed_pcb = removeProcQ(&(curr_ptr->s_procQ));
@@ -210,10 +216,11 @@ pcb_PTR removeBlocked(int *semAdd) {
     if (removed_pcb == NULL) return NULL;
 
     removed_pcb->p_semAdd = NULL;
+    removed_pcb->p_semd = NULL;
 
     /* If queue is empty, remove the semaphore from ASL */
     if (emptyProcQ(curr_ptr->s_procQ)) {
-        prev_ptr->s_next = curr_ptr->s_next;
+        *link = curr_ptr->s_next;
         freeSemaphore(curr_ptr);
     }
 
@@ -222,31 +229,70 @@ pcb_PTR removeBlocked(int *semAdd) {
 
 
 
+/**************************************************************************** 
+ *  removeAllBlocked
+ *  Detach the whole process queue of the semaphore whose address is semAdd in 
+ *  one step: the descriptor is unlinked from the ASL and returned to the 
+ *  semdFree list after a single hash lookup, and its queue is handed back 
+ *  as-is (tail pointer), ready to be spliced onto another queue with mergeProcQ().
+ *  Each detached pcb still gets its semaphore address/descriptor cleared, since 
+ *  the Nucleus tells blocked pcbs apart by p_semd; that walk touches only the 
+ *  detached pcbs, never the ASL.
+ * 
+ *  params: memory address semAdd of a semaphore descriptor, 
+ *          count (if not NULL) receives the number of pcbs detached
+ *  return: tail pointer of the detached process queue. Otherwise (semAdd not 
+ *          active), an empty process queue
+ *****************************************************************************/
+pcb_PTR removeAllBlocked(int *semAdd, int *count) {
+    semd_PTR *link = search_semp(semAdd);
+    semd_PTR curr_ptr = *link;
+    pcb_PTR tail;
+    pcb_PTR p;
+    int n = 0;
+
+    /* If the semaphore is not found, there is nothing to detach */
+    if (curr_ptr == NULL) {
+        if (count != NULL) *count = 0;
+        return mkEmptyProcQ();
+    }
+
+    /* Take the queue and give the descriptor back */
+    tail = curr_ptr->s_procQ;
+    *link = curr_ptr->s_next;
+    freeSemaphore(curr_ptr);
+
+    /* The detached pcbs are no longer blocked */
+    p = tail;
+    do {
+        p = p->p_next;
+        p->p_semAdd = NULL;
+        p->p_semd = NULL;
+        n++;
+    } while (p != tail);
+
+    if (count != NULL) *count = n;
+    return tail;
+}
+
+
+
 /**************************************************************************** 
  *  outBlocked
  *  Remove the pcb pointed to by p from the process queue associated with p’s 
- *  semaphore (p→ p semAdd) on the ASL. If pcb pointed to by p does not appear in 
- *  the process queue associated with p’s semaphore, return NULL
+ *  semaphore (p→ p semAdd) on the ASL. If pcb pointed to by p is not blocked 
+ *  on any semaphore, return NULL
+ *  The descriptor is reached directly through p's back-pointer (p->p_semd), 
+ *  and p is unlinked from its process queue in O(1). Only when the queue 
+ *  becomes empty is semAdd's (short) hash bucket walked to unlink the descriptor.
  * 
  *  params: pointer p to a pcb
  *  return: pointer to the removed pcb. Otherwise, return NULL
  *****************************************************************************/
 pcb_PTR outBlocked(pcb_PTR p) {
-    if (p == NULL || p->p_semAdd == NULL) return NULL;
-
-    int *semAdd = p->p_semAdd;
+    if (p == NULL || p->p_semd == NULL) return NULL;
 
-    semd_PTR prev_ptr = search_semp(semAdd);
-    semd_PTR curr_ptr;
-
-    if (prev_ptr != NULL) {
-        curr_ptr = prev_ptr->s_next;
-    } else {
-        curr_ptr = NULL;
-    }
-
-    /* If the semaphore is not found, return NULL */
-    if (curr_ptr == NULL || curr_ptr->s_semAdd != semAdd) return NULL;
+    semd_PTR curr_ptr = p->p_semd;
 
     /* Remove the process from the semaphore's queue */
     pcb_PTR removed_pcb = outProcQ(&(curr_ptr->s_procQ), p);
@@ -254,14 +300,16 @@ pcb_PTR outBlocked(pcb_PTR p) {
     /* If process was not in the queue, return NULL */
     if (removed_pcb == NULL) return NULL;
 
-    removed_pcb->p_semAdd = NULL;
-
     /* If the process queue becomes empty, remove semaphore from ASL */
     if (emptyProcQ(curr_ptr->s_procQ)) {
-        prev_ptr->s_next = curr_ptr->s_next;
+        semd_PTR *link = search_semp(p->p_semAdd);
+        *link = curr_ptr->s_next;
         freeSemaphore(curr_ptr);
     }
 
+    removed_pcb->p_semAdd = NULL;
+    removed_pcb->p_semd = NULL;
+
     return removed_pcb;
 }
 
@@ -279,16 +327,10 @@ pcb_PTR outBlocked(pcb_PTR p) {
 pcb_PTR headBlocked(int *semAdd) {
     if (semAdd == NULL) return NULL;
 
-    semd_PTR curr_ptr = search_semp(semAdd);
-
-    if (curr_ptr != NULL) {
-        curr_ptr = curr_ptr->s_next;
-    } else {
-        curr_ptr = NULL;
-    }
+    semd_PTR curr_ptr = *search_semp(semAdd);
 
     /* If semaphore not found, return NULL */
-    if (curr_ptr == NULL || curr_ptr->s_semAdd != semAdd) return NULL;
+    if (curr_ptr == NULL) return NULL;
 
     /* Return the head of the process queue */
     return headProcQ(curr_ptr->s_procQ);
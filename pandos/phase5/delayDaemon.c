@@ -8,7 +8,8 @@
  *      - A statically allocated pool of delay descriptor nodes, maintained through a free list.
  *      - An Active Delay List (ADL), implemented as a singly linked list with dummy head and tail 
  *        nodes, sorted in ascending order by wakeTime for efficient insertion and traversal.
- *      - A delay daemon process that periodically (every 100ms) checks the ADL, wakes up 
+ *      - A delay daemon process that periodically (every 100ms, or only when the head of 
+ *        the ADL is due when the system is idle - tickless idle) checks the ADL, wakes up 
  *        processes whose delay period has expired by performing SYS4 on their private semaphores, and 
  *        returns the corresponding descriptors to the free list.
  *      - Support for SYS18, which inserts sleeping U-procs into the ADL and blocks 
@@ -233,6 +234,7 @@ int insertADL(int time_asleep, support_t *supStruct){
     delayd_PTR prev = find_insert_position(newDescriptor->d_wakeTime); /*Find correct position in ADL to insert new descriptor node*/
     newDescriptor->d_next = prev->d_next;
     prev->d_next = newDescriptor;
+    requestClockBy(newDescriptor->d_wakeTime); /*the daemon may be waiting on a later (or no) deadline*/
 
     return TRUE;
 }
@@ -245,6 +247,8 @@ int insertADL(int time_asleep, support_t *supStruct){
  * their private semaphores.
  * 
  * @note: Freed descriptors are returned to the free list.
+ * @note: The daemon passes the wakeTime at the head of the ADL to SYS7, so that an idle 
+ *        Nucleus can sleep right up to it instead of waking every 100ms (tickless idle).
  * 
  * @param: None
  * @return: None
@@ -254,9 +258,10 @@ int insertADL(int time_asleep, support_t *supStruct){
  **************************************************************************************************/
 void delayDaemon(){
     cpu_t curr_time; /* Stores current time from TOD clock */
+    cpu_t nextWake = LARGETIME; /* wakeTime at the head of the ADL (LARGETIME if empty) */
 
     while (TRUE){ /*inifinite loop*/
-        SYSCALL(SYS7,0,0,0); /* Wait for 100ms clock tick */
+        SYSCALL(SYS7,(int) nextWake,0,0); /* Wait for a clock tick - no need to wake before nextWake (tickless idle) */
         SYSCALL(SYS3,(int) &delayDaemon_sema4,0,0); /*Acquire mutex on ADL (lock ADL)*/
         STCK(curr_time); /* Get current time from TOD clock */
 
@@ -268,6 +273,7 @@ void delayDaemon(){
             free_descriptor(curr);  /* Return descriptor to the free list */
             curr = delayd_h->d_next; /* Move to next descriptor in ADL */
         }
+        nextWake = curr->d_wakeTime; /* Earliest wakeTime still pending (dummy tail: LARGETIME) */
         SYSCALL(SYS4,(int)&delayDaemon_sema4,0,0); /*Release mutex on ADL (unlock ADL)*/
     }
 }
@@ -30,6 +30,9 @@
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"
 #include "../h/deviceSupportDMA.h"
+#include "../h/swapSpace.h"
+#include "../h/diskSched.h"
+#include "../h/diskCache.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /**************************************************************************************************  
@@ -38,16 +41,19 @@
  * Steps:
  *  1. Extract disk geometry from device register DATA1 field: maxcyl, maxhead, maxsect
  *  2. Validate sector number to ensure it's within disk capacity (prevent invalid access)
- *  3. Lock target disk device semaphore
- *  4. Compute cylinder,head,sector from linear sector number requested by calling uproc
+ *     With DISKCACHE on, the sector goes to the block cache instead (dcache_put, diskCache.c): the
+ *     disk is written when the daemon or SYS22 writes the entry back
+ *  3. Compute cylinder,head,sector from linear sector number requested by calling uproc
+ *  4. Get the disk (disk_acquire): wait in its request queue, served in C-LOOK order by cylinder
  *  5. Copy 4KB data from uproc address space to disk's DMA buffer
- *  6. Seek to the correct cylinder (issue seek command + block uproc on ASL until seek completes)
+ *  6. Seek to the correct cylinder (disk_seek: issue seek command + block uproc on ASL until seek
+ *     completes, left out when the head is already on that cylinder)
  *  6. If disk SEEK successful:
  *     a. Put starting address of DMA buffer into register v0
  *     b. Issue WRITE command to requested sector
  *     c. Block uproc on ASL until WRITE op completes
  *  7. If operation succeeded, return status in v0; otherwise return negative status code.
- *  8. Release device semaphore
+ *  8. Hand the disk to the next queued request (disk_release)
  * 
  *  @param logicalAddr Pointer to 4KB data in uproc logical address to be written to disk.
  *  @param diskNo      Disk device number to write to
@@ -68,6 +74,9 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     int status;                          /* Disk device operation status code */                             
 
     busRegArea = (devregarea_t *) RAMBASEADDR; /*Access device register base*/
+    if ((diskNo < 0) || (diskNo >= DEV_UNITS)) { /*no such disk (its queue and DMA buffer would be out of range)*/
+        get_nuked(NULL);
+    }
 
     /*Extract disk geometry values*/
     maxSect = (busRegArea->devreg[diskNo].d_data1 & LOWERMASK);
@@ -78,18 +87,27 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     if ( (sectNo < 0) || ((int)logicalAddr < KUSEG) || (sectNo > (maxCyl * maxHead * maxSect))) {
         get_nuked(NULL); 
     }
-    
-    /*Lock target disk device semaphore*/
-    SYSCALL(SYS3, (memaddr)&devSema4_support[diskNo], 0, 0); 
 
-    /*Calculate the base address of the disk's DMA buffer for this disk unit*/
-    dmaBuffer = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
+#if DISKCACHE
+    /*Served by the block cache (sectors past the end still go to the disk, which reports the error)*/
+    if (sectNo < (maxCyl * maxHead * maxSect)) {
+        status = dcache_put(diskNo, sectNo, logicalAddr);
+        support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = (status == READY) ? status : -status;
+        return;
+    }
+#endif
 
     /* Convert linear sector number into Cylinder-Head-Sector triplet */
     cylNum = sectNo / (maxHead * maxSect);
     sectNo = sectNo % (maxHead * maxSect);
     headNum = sectNo / maxSect;
     sectNo = sectNo % maxSect;
+    
+    /*Get the disk: wait in its request queue, served in cylinder order (diskSched.c)*/
+    disk_acquire(diskNo, cylNum);
+
+    /*Calculate the base address of the disk's DMA buffer for this disk unit*/
+    dmaBuffer = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
 
     /*Copy 4KB data from user process memory to disk DMA buffer*/
     int i;
@@ -102,14 +120,11 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     dmaBuffer = (memaddr *)(DISKSTART + (diskNo * PAGESIZE)); /*reset dmaBuffer to issue correct starting address for later WRITE op*/
 
 
-    setSTATUS(NO_INTS);
-    busRegArea->devreg[diskNo].d_command = (cylNum << LEFTSHIFT8) | SEEK_CMD; /*issue SEEK command*/
-    status = SYSCALL(SYS5, DISKINT, diskNo, 0); /*Block current proc until SEEK op completes*/
-    setSTATUS(YES_INTS);
+    status = disk_seek(diskNo, cylNum); /*SEEK to the cylinder, blocking until done (left out if the head is already there)*/
 
     if (status != READY){ /*If seek unsucessful*/
         support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = -status;
-        SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+        disk_release(diskNo);
         return;
     } else{ /*If seek successful*/
         setSTATUS(NO_INTS);
@@ -125,8 +140,9 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
         } 
         else{ /*If WRITE op unsuccessful*/
             support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = -status;
+            disk_head_lost(diskNo);
         }
-        SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0); /*Release disk device semaphore*/
+        disk_release(diskNo); /*hand the disk to the next request*/
     } 
 }
 
@@ -137,17 +153,20 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
  * Steps:
  *  1. Extract disk geometry from device register DATA1 field: maxcyl, maxhead, maxsect
  *  2. Validate sector number to ensure it's within disk capacity (prevent invalid access)
- *  3. Lock target disk device semaphore
- *  4. Locate appropriate disk DMA buffer in RAM
- *  5. Compute cylinder,head,sector from linear sector number requested by calling uproc 
- *  6. Seek to the correct cylinder (issue seek command + block uproc on ASL until seek completes)
+ *     With DISKCACHE on, the sector comes from the block cache instead (dcache_get, diskCache.c),
+ *     which reads it from the disk on a miss
+ *  3. Compute cylinder,head,sector from linear sector number requested by calling uproc
+ *  4. Get the disk (disk_acquire): wait in its request queue, served in C-LOOK order by cylinder
+ *  5. Locate appropriate disk DMA buffer in RAM
+ *  6. Seek to the correct cylinder (disk_seek: issue seek command + block uproc on ASL until seek
+ *     completes, left out when the head is already on that cylinder)
  *  7. If disk SEEK successful:
  *     a. Put starting address of DMA buffer into register v0
  *     b. Issue READ command to read in correct disk sector into dma buffer
  *     c. Block uproc on ASL until READ op completes
  *  8. If operation succeeded, copy content of dma buffer to uproc's logical address space
  *  9. Return status in v0
- * 10. Release target disk device semaphore
+ * 10. Hand the disk to the next queued request (disk_release)
  * 
  *  @param logicalAddr Pointer to 4KB data in uproc logical address space where disk data will be stored
  *  @param diskNo      Disk device number to read from
@@ -169,6 +188,9 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     int status;                          /* Disk device operation status code */    
 
     busRegArea = (devregarea_t *) RAMBASEADDR; /*Access device register base*/
+    if ((diskNo < 0) || (diskNo >= DEV_UNITS)) { /*no such disk (its queue and DMA buffer would be out of range)*/
+        get_nuked(NULL);
+    }
 
     /*Extract disk geometry values*/
     maxCyl = (busRegArea->devreg[diskNo].d_data1 >> CYLADDRSHIFT);
@@ -180,12 +202,14 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
         get_nuked(NULL); 
     }
 
-    /*Lock target disk device semaphore*/
-    SYSCALL(SYS3, (memaddr)&devSema4_support[diskNo], 0, 0);
-
-    /*Calculate the base address of the disk's DMA buffer for this disk unit*/
-    dmaBuffer = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
-    memaddr *originBuff = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
+#if DISKCACHE
+    /*Served by the block cache (sectors past the end still go to the disk, which reports the error)*/
+    if (sectNo < (maxCyl * maxHead * maxSect)) {
+        status = dcache_get(support_struct->sup_asid, diskNo, sectNo, logicalAddr);
+        support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = (status == READY) ? status : -status;
+        return;
+    }
+#endif
 
     /* Convert linear sector number into Cylinder-Head-Sector triplet */
     cylNum = sectNo / (maxHead * maxSect);
@@ -193,14 +217,18 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     headNum = sectNo / maxSect;
     sectNo = sectNo % maxSect;
 
-    setSTATUS(NO_INTS);
-    busRegArea->devreg[diskNo].d_command = (cylNum << LEFTSHIFT8) | SEEK_CMD; /*issue SEEK command*/
-    status = SYSCALL(SYS5, DISKINT, diskNo, 0); /*Block uproc on ASL until WRITE op completes*/
-    setSTATUS(YES_INTS);
+    /*Get the disk: wait in its request queue, served in cylinder order (diskSched.c)*/
+    disk_acquire(diskNo, cylNum);
+
+    /*Calculate the base address of the disk's DMA buffer for this disk unit*/
+    dmaBuffer = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
+    memaddr *originBuff = (memaddr *)(DISKSTART + (diskNo * PAGESIZE));
+
+    status = disk_seek(diskNo, cylNum); /*SEEK to the cylinder, blocking until done (left out if the head is already there)*/
 
     if (status != READY) { /*If seek unsucessful*/
         support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = -status;
-        SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+        disk_release(diskNo);
         return;
     } else { /*If seek sucessful*/
         setSTATUS(NO_INTS);
@@ -213,7 +241,8 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
     
         if (status != READY) { /*If READ op unsuccessful*/
             support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = -status;
-            SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+            disk_head_lost(diskNo);
+            disk_release(diskNo);
             return;
         }
         /*If READ op successful*/
@@ -226,8 +255,47 @@ void disk_put(memaddr *logicalAddr, int diskNo, int sectNo, support_t *support_s
         }
 
         support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = status;
-        SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0); /*release disk device semaphore*/
+        disk_release(diskNo); /*hand the disk to the next request*/
+    }
+}
+
+/**************************************************************************************************  
+ * Transfers one sector between a disk and a 4KB kernel frame (the block cache's), with no copy
+ * through the disk's DMA buffer. Takes its turn in the disk's request queue like SYS14/SYS15
+ * 
+ *  @param diskNo  Disk device number
+ *  @param sectNo  Linear sector number (already validated by the caller)
+ *  @param command READBLK or WRITEBLK
+ *  @param buffer  Physical address of the frame
+ *  @return READY, or the device status of the failed SEEK or transfer
+ **************************************************************************************************/
+int disk_io(int diskNo, int sectNo, int command, memaddr buffer) {
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    int maxHead = (busRegArea->devreg[diskNo].d_data1 & HEADMASK) >> HEADADDRSHIFT;
+    int maxSect = (busRegArea->devreg[diskNo].d_data1 & LOWERMASK);
+    int headNum, cylNum;
+    int status;
+
+    /* Convert linear sector number into Cylinder-Head-Sector triplet */
+    cylNum = sectNo / (maxHead * maxSect);
+    sectNo = sectNo % (maxHead * maxSect);
+    headNum = sectNo / maxSect;
+    sectNo = sectNo % maxSect;
+
+    disk_acquire(diskNo, cylNum);
+    status = disk_seek(diskNo, cylNum);
+    if (status == READY) {
+        setSTATUS(NO_INTS);
+        busRegArea->devreg[diskNo].d_data0 = buffer;
+        busRegArea->devreg[diskNo].d_command = (headNum << LEFTSHIFT16) | (sectNo << LEFTSHIFT8) | command;
+        status = SYSCALL(SYS5, DISKINT, diskNo, 0); /*Block until the transfer completes*/
+        setSTATUS(YES_INTS);
+        if (status != READY) {
+            disk_head_lost(diskNo);
+        }
     }
+    disk_release(diskNo);
+    return status;
 }
 
 /**************************************************************************************************  
@@ -306,6 +374,7 @@ void flashOperation(memaddr *logicalAddr, int flashNo, int blockNo, int operatio
 
     /* Lock target flash device semaphore */
     SYSCALL(SYS3, (memaddr)&devSema4_support[DEV_UNITS + flashNo], 0, 0);
+    devHolder[DEV_UNITS + flashNo] = support_struct->sup_asid; /*released by get_nuked() if it traps holding it*/
 
     /* Calculate the base address of the flash's DMA buffer */
     dmaBuffer = (memaddr *)(FLASHSTART + (flashNo * PAGESIZE));
@@ -316,8 +385,8 @@ void flashOperation(memaddr *logicalAddr, int flashNo, int blockNo, int operatio
     f_device = &busRegArea->devreg[devIdx];
     maxBlock = f_device->d_data1; /*Retrieve max number of valid blocks supported by the target device*/
 
-    /* Validate block number */
-    if (blockNo >= maxBlock) {
+    /* Validate block number (the swap area at the top of the device belongs to the Pager) */
+    if (blockNo >= maxBlock || blockNo >= swap_user_blocks(flashNo)) {
         get_nuked(NULL);
     }
 
@@ -352,6 +421,7 @@ void flashOperation(memaddr *logicalAddr, int flashNo, int blockNo, int operatio
     support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = status;
 
     /*Unlock flash device semaphore */
+    devHolder[DEV_UNITS + flashNo] = FREE;
     SYSCALL(SYS4, (memaddr)&devSema4_support[DEV_UNITS + flashNo], 0, 0);
 }
 
@@ -0,0 +1,537 @@
+/**************************************************************************************************
+ * @file diskCache.c
+ *
+ * @brief
+ * This module implements the disk block cache: DISKCACHE 4KB disk sectors kept in kernel frames
+ * reserved right after the DMA buffers (DCACHESTART), so that SYS15 on a sector that the same or
+ * another u-proc recently read or wrote is a copy from RAM instead of a SEEK and a READBLK.
+ *      - dcache_get/dcache_put serve SYS15/SYS14 (disk_get/disk_put in deviceSupportDMA.c): a hit
+ *        copies the sector, a miss takes the least recently used entry (writing it back first if
+ *        it is dirty) and, for SYS15, reads the sector into it straight from the disk.
+ *      - Writes only go to the cache (write-back). The first store to a clean cache wakes the flush
+ *        daemon, a kernel process (ASID 0) that writes every dirty sector back DISKFLUSHTIME later;
+ *        SYS22 (DISKSYNC) writes them back at once, for a u-proc that needs its data on the disk.
+ *      - Read-ahead: once a u-proc reads two consecutive sectors of a disk, dcache_get queues the
+ *        next DISKREADAHEAD sectors for the read-ahead daemon (another kernel process), which reads
+ *        them into the cache while the u-proc copies the current sector and runs; a sequential scan
+ *        then finds its sectors cached, or waits on an entry already being read.
+ *
+ * @details
+ * The entry table is guarded by dcacheSema4, which is never held during I/O or while copying to
+ * or from a u-proc (a copy may page fault). An entry being read, written back or copied is busy:
+ * it is never chosen as a victim, and a request for its sector waits on the entry itself (as a
+ * fault on a busy swap pool frame does in vmSupport.c). A dirty entry stays dirty until its
+ * write-back has completed, so DISKSYNC also waits for write-backs already under way.
+ *
+ * @note
+ * Sector transfers use disk_io(), DMA to and from the cache frame, and are scheduled like any
+ * other disk request (diskSched.c). A write-back that fails leaves the entry dirty, and the error
+ * is reported by DISKSYNC (the flush daemon tries again on its next pass). A miss whose victim
+ * fails to write back marks that entry most recently used and takes another victim; it
+ * only fails itself when no entry could be written back. Build with make DISKCACHE=0 to leave
+ * the cache out.
+ *
+ * @authors
+ * Nicolas & Tran
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project
+ **************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/sysSupport.h"
+#include "../h/deviceSupportDMA.h"
+#include "../h/diskSched.h"
+#include "../h/diskCache.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+HIDDEN dcache_t dcache[DCACHESLOTS]; /*the cache entries, entry i in frame DCACHESTART + i pages*/
+HIDDEN int dcacheSema4;              /*guards the entry table*/
+HIDDEN unsigned int dcacheClock;     /*LRU stamps handed out so far*/
+HIDDEN int dirtyCnt;                 /*dirty entries*/
+HIDDEN int idleWaiters;              /*misses waiting for any entry to leave transit*/
+HIDDEN int idleSema4;                /*they wait here*/
+HIDDEN int flushSema4;               /*the flush daemon waits here for a dirty entry*/
+HIDDEN int flushPending;             /*TRUE from a kick until the daemon's next pass is done*/
+HIDDEN int raLast[MAXUPROCS + 1][DEV_UNITS]; /*last sector each u-proc read from each disk, FREE if none*/
+HIDDEN int raNext[MAXUPROCS + 1][DEV_UNITS]; /*first sector of its stream not yet queued for read-ahead*/
+HIDDEN int raDisk[DISKRAQLEN];       /*read-ahead queue (a ring): disk and sector of each request*/
+HIDDEN int raSect[DISKRAQLEN];
+HIDDEN int raHead;                   /*oldest request*/
+HIDDEN int raCount;                  /*requests queued*/
+HIDDEN int raSema4;                  /*the read-ahead daemon waits here, one V per request*/
+
+/**************************************************************************************************
+ * @brief Physical address of the frame of cache entry i
+ **************************************************************************************************/
+HIDDEN memaddr entry_frame(int i){
+    return DCACHESTART + (i * PAGESIZE);
+}
+
+/**************************************************************************************************
+ * @brief Per-entry transit state, called with dcacheSema4 held.
+ *
+ * entry_wait: returns with dcacheSema4 released once the entry has left transit (the caller
+ *             re-acquires it and looks again)
+ * idle_wait: likewise, once any entry has left transit (a miss finding every entry busy)
+ * entry_release: ends the transit of an entry and wakes its waiters and the idle_wait ones
+ **************************************************************************************************/
+HIDDEN void entry_wait(int i){
+    dcache[i].dc_waiters++;
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    SYSCALL(SYS3, (memaddr)&dcache[i].dc_sema4, 0, 0);
+}
+
+HIDDEN void idle_wait(){
+    idleWaiters++;
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    SYSCALL(SYS3, (memaddr)&idleSema4, 0, 0);
+}
+
+HIDDEN void entry_release(int i){
+    dcache[i].dc_busy = FALSE;
+    while (dcache[i].dc_waiters > 0){
+        dcache[i].dc_waiters--;
+        SYSCALL(SYS4, (memaddr)&dcache[i].dc_sema4, 0, 0);
+    }
+    while (idleWaiters > 0){
+        idleWaiters--;
+        SYSCALL(SYS4, (memaddr)&idleSema4, 0, 0);
+    }
+}
+
+/**************************************************************************************************
+ * @brief Wakes the flush daemon if there is a dirty entry and it is not already due to run.
+ * Called with dcacheSema4 held
+ **************************************************************************************************/
+HIDDEN void flush_kick(){
+    if (dirtyCnt > 0 && !flushPending){
+        flushPending = TRUE;
+        SYSCALL(SYS4, (memaddr)&flushSema4, 0, 0);
+    }
+}
+
+/**************************************************************************************************
+ * @brief Entry holding a sector, FREE if it is not cached. Called with dcacheSema4 held
+ **************************************************************************************************/
+HIDDEN int lookup(int diskNo, int sectNo){
+    int i;
+
+    for (i = 0; i < DISKCACHE; i++){
+        if (dcache[i].dc_disk == diskNo && dcache[i].dc_sector == sectNo){
+            return i;
+        }
+    }
+    return FREE;
+}
+
+/**************************************************************************************************
+ * @brief Entry to reuse for a new sector: an empty one, or the least recently used one not in
+ * transit (FREE if all are). Called with dcacheSema4 held
+ **************************************************************************************************/
+HIDDEN int victim(){
+    int i;
+    int best = FREE;
+
+    for (i = 0; i < DISKCACHE; i++){
+        if (dcache[i].dc_busy){
+            continue;
+        }
+        if (dcache[i].dc_disk == FREE){
+            return i;
+        }
+        if (best == FREE || dcache[i].dc_lastUse < dcache[best].dc_lastUse){
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**************************************************************************************************
+ * @brief Writes a dirty entry back to its sector. Called with dcacheSema4 held and the entry
+ * marked busy by the caller; returns with dcacheSema4 held again and the entry still busy
+ *
+ * @return: READY, or the device status of the failed transfer (the entry stays dirty)
+ **************************************************************************************************/
+HIDDEN int write_back(int i){
+    int status;
+
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    status = disk_io(dcache[i].dc_disk, dcache[i].dc_sector, WRITEBLK, entry_frame(i));
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+
+    if (status == READY){
+        dcache[i].dc_dirty = FALSE;
+        dirtyCnt--;
+        diskStats[dcache[i].dc_disk].ds_writebacks++;
+    }
+    return status;
+}
+
+/**************************************************************************************************
+ * @brief Gets the entry for a sector in transit for the caller: the cached one (hit), or the
+ * victim entry, renamed to the sector and, with fill set, read from the disk (miss)
+ *
+ * @param: diskNo, sectNo - the sector; fill - TRUE to read the sector on a miss (SYS15), FALSE
+ *         when the caller overwrites all of it (SYS14); entry - set to the entry's index
+ * @return: READY (the caller ends the transit with entry_release()), or the device status of the
+ *          failed read, or of the last failed write-back when DISKCACHE victims in a row could not
+ *          be written back (no entry can take the sector)
+ **************************************************************************************************/
+HIDDEN int claim(int diskNo, int sectNo, int fill, int *entry){
+    int i;
+    int status;
+    int failed = 0; /*victims that failed to write back*/
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0); /*lock the cache*/
+    while (TRUE){
+        i = lookup(diskNo, sectNo);
+        if (i != FREE){
+            if (dcache[i].dc_busy){ /*being read, written back or copied: wait for it and look again*/
+                entry_wait(i);
+                SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+                continue;
+            }
+            diskStats[diskNo].ds_hits++;
+            dcache[i].dc_busy = TRUE;
+            dcache[i].dc_lastUse = ++dcacheClock;
+            SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+            *entry = i;
+            return READY;
+        }
+
+        i = victim();
+        if (i == FREE){ /*every entry in transit: wait for one to leave it*/
+            idle_wait();
+            SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+            continue;
+        }
+        dcache[i].dc_busy = TRUE;
+        if (dcache[i].dc_dirty){ /*write the old sector back, then look again (the sector may have been cached meanwhile)*/
+            status = write_back(i);
+            if (status != READY){ /*keep it (dirty, for the flush daemon or DISKSYNC), try the next victim*/
+                dcache[i].dc_lastUse = ++dcacheClock;
+                if (++failed >= DISKCACHE){
+                    entry_release(i);
+                    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+                    return status;
+                }
+            }
+            entry_release(i);
+            continue;
+        }
+
+        diskStats[diskNo].ds_misses++;
+        dcache[i].dc_disk = diskNo;
+        dcache[i].dc_sector = sectNo;
+        dcache[i].dc_lastUse = ++dcacheClock;
+        SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+
+        if (fill){
+            status = disk_io(diskNo, sectNo, READBLK, entry_frame(i));
+            if (status != READY){ /*the entry holds nothing*/
+                SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+                dcache[i].dc_disk = FREE;
+                entry_release(i);
+                SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+                return status;
+            }
+        }
+        *entry = i;
+        return READY;
+    }
+}
+
+/**************************************************************************************************
+ * @brief Number of sectors of a disk, from its geometry (DATA1)
+ **************************************************************************************************/
+HIDDEN int disk_sectors(int diskNo){
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    unsigned int geometry = busRegArea->devreg[diskNo].d_data1;
+
+    return (geometry >> CYLADDRSHIFT) * ((geometry & HEADMASK) >> HEADADDRSHIFT) * (geometry & LOWERMASK);
+}
+
+/**************************************************************************************************
+ * @brief Follows the SYS15 stream of a u-proc on a disk: when sectNo comes right after the sector
+ * it read last, queues the sectors up to DISKREADAHEAD past it that are not queued yet for the
+ * read-ahead daemon (dropping them if the queue is full). Called with dcacheSema4 held
+ **************************************************************************************************/
+HIDDEN void read_ahead(int asid, int diskNo, int sectNo){
+    int limit;
+    int sequential = (raLast[asid][diskNo] != FREE && sectNo == raLast[asid][diskNo] + 1);
+
+    raLast[asid][diskNo] = sectNo;
+    if (!sequential || raNext[asid][diskNo] <= sectNo){ /*a new stream, or it overtook its read-ahead*/
+        raNext[asid][diskNo] = sectNo + 1;
+    }
+    if (!sequential){
+        return;
+    }
+
+    limit = sectNo + ((DISKREADAHEAD < DISKCACHE / 2) ? DISKREADAHEAD : DISKCACHE / 2);
+    if (limit >= disk_sectors(diskNo)){
+        limit = disk_sectors(diskNo) - 1;
+    }
+    while (raNext[asid][diskNo] <= limit && raCount < DISKRAQLEN){
+        raDisk[(raHead + raCount) % DISKRAQLEN] = diskNo;
+        raSect[(raHead + raCount) % DISKRAQLEN] = raNext[asid][diskNo]++;
+        raCount++;
+        SYSCALL(SYS4, (memaddr)&raSema4, 0, 0);
+    }
+}
+
+/**************************************************************************************************
+ * @brief Reads a sector into the cache for the read-ahead daemon, unless it is cached already or
+ * no clean entry is free to take it (read-ahead never writes a victim back)
+ **************************************************************************************************/
+HIDDEN void prefetch(int diskNo, int sectNo){
+    int i;
+    int status;
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    i = victim();
+    if (lookup(diskNo, sectNo) != FREE || i == FREE || dcache[i].dc_dirty){
+        SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+        return;
+    }
+    dcache[i].dc_busy = TRUE;
+    dcache[i].dc_disk = diskNo;
+    dcache[i].dc_sector = sectNo;
+    dcache[i].dc_lastUse = ++dcacheClock;
+    diskStats[diskNo].ds_readahead++;
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+
+    status = disk_io(diskNo, sectNo, READBLK, entry_frame(i));
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    if (status != READY){ /*the entry holds nothing*/
+        dcache[i].dc_disk = FREE;
+    }
+    entry_release(i);
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+}
+
+/**************************************************************************************************
+ * @brief Reads a disk sector through the cache into a u-proc's buffer (SYS15)
+ *
+ * @param: asid - the reading u-proc (its stream is followed for read-ahead); diskNo, sectNo - the
+ *         sector (validated by disk_get); dest - 4KB buffer in kuseg
+ * @return: READY, or the device status of the failed transfer
+ **************************************************************************************************/
+int dcache_get(int asid, int diskNo, int sectNo, memaddr *dest){
+    memaddr *frame;
+    int status;
+    int i;
+    int w;
+
+    status = claim(diskNo, sectNo, TRUE, &i);
+    if (status != READY){
+        return status;
+    }
+
+#if DISKREADAHEAD
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    read_ahead(asid, diskNo, sectNo); /*the daemon reads on while the sector is copied*/
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+#endif
+
+    frame = (memaddr *) entry_frame(i);
+    for (w = 0; w < BLOCKS_4KB; w++){
+        dest[w] = frame[w];
+    }
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    entry_release(i);
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    return READY;
+}
+
+/**************************************************************************************************
+ * @brief Writes a u-proc's buffer to a disk sector through the cache (SYS14). The disk is only
+ * written when the entry is written back
+ *
+ * @param: diskNo, sectNo - the sector (validated by disk_put); src - 4KB buffer in kuseg
+ * @return: READY, or the device status of the last victim write-back when none could be written back
+ **************************************************************************************************/
+int dcache_put(int diskNo, int sectNo, memaddr *src){
+    memaddr *frame;
+    int status;
+    int i;
+    int w;
+
+    status = claim(diskNo, sectNo, FALSE, &i);
+    if (status != READY){
+        return status;
+    }
+
+    frame = (memaddr *) entry_frame(i);
+    for (w = 0; w < BLOCKS_4KB; w++){
+        frame[w] = src[w];
+    }
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    if (!dcache[i].dc_dirty){
+        dcache[i].dc_dirty = TRUE;
+        dirtyCnt++;
+    }
+    entry_release(i);
+    flush_kick();
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    return READY;
+}
+
+/**************************************************************************************************
+ * @brief Writes every dirty entry back, waiting for those in transit (including write-backs
+ * already started by others)
+ *
+ * @return: READY, or the device status of the first write-back that failed
+ **************************************************************************************************/
+int dcache_sync(){
+    int status = READY;
+    int result;
+    int i = 0;
+
+    SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+    while (i < DISKCACHE){
+        if (!dcache[i].dc_dirty){
+            i++;
+            continue;
+        }
+        if (dcache[i].dc_busy){
+            entry_wait(i);
+            SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+            continue; /*look at the same entry again*/
+        }
+        dcache[i].dc_busy = TRUE;
+        result = write_back(i);
+        entry_release(i);
+        if (result != READY){
+            if (status == READY){
+                status = result;
+            }
+            i++; /*leave it dirty*/
+        }
+    }
+    SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    return status;
+}
+
+/**************************************************************************************************
+ * @brief The method implements SYS22 (DISKSYNC) - write the dirty sectors of the block cache back
+ * to the disks, returning READY in v0, or the negated status of a failed write-back
+ *
+ * @param: support_struct - pointer to support struct of current uproc
+ * @return: None
+ **************************************************************************************************/
+void disk_sync(support_t *support_struct){
+    int status = dcache_sync();
+    support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = (status == READY) ? status : -status;
+}
+
+/**************************************************************************************************
+ * @brief Code of the flush daemon. Sleeps until a store makes an entry dirty, waits DISKFLUSHTIME
+ * so that the stores that follow are written back together, then writes every dirty entry back
+ **************************************************************************************************/
+void diskFlusher(){
+    cpu_t now;
+    cpu_t wake;
+
+    while (TRUE){ /*inifinite loop*/
+        SYSCALL(SYS3, (memaddr)&flushSema4, 0, 0); /*wait for a kick*/
+
+        STCK(now);
+        wake = now + DISKFLUSHTIME;
+        while (now < wake){
+            SYSCALL(SYS7, (int) wake, 0, 0); /*no need to wake before then (tickless idle)*/
+            STCK(now);
+        }
+        dcache_sync();
+
+        SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+        flushPending = FALSE;
+        flush_kick(); /*dirtied again during the pass, or a write-back failed: another pass later*/
+        SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+    }
+}
+
+/**************************************************************************************************
+ * @brief Code of the read-ahead daemon. Reads the queued sectors into the cache, oldest first
+ **************************************************************************************************/
+void diskReadAhead(){
+    int diskNo;
+    int sectNo;
+
+    while (TRUE){ /*inifinite loop*/
+        SYSCALL(SYS3, (memaddr)&raSema4, 0, 0); /*wait for a request*/
+
+        SYSCALL(SYS3, (memaddr)&dcacheSema4, 0, 0);
+        diskNo = raDisk[raHead];
+        sectNo = raSect[raHead];
+        raHead = (raHead + 1) % DISKRAQLEN;
+        raCount--;
+        SYSCALL(SYS4, (memaddr)&dcacheSema4, 0, 0);
+
+        prefetch(diskNo, sectNo);
+    }
+}
+
+/**************************************************************************************************
+ * @brief Launches a cache daemon (kernel ASID, kernel mode, no support structure) via SYS1, with
+ * its stack stackPg pages below the top of RAM (inside the KERNSTACKPAGES kept free for kernel
+ * stacks)
+ **************************************************************************************************/
+HIDDEN void launch_daemon(void (*code)(), int stackPg){
+    memaddr topRAM;
+    state_t daemonState;
+
+    RAMTOP(topRAM);
+    daemonState.s_entryHI = (DAEMONID << SHIFT_ASID); /*kernel ASID*/
+    daemonState.s_pc = (memaddr) code;
+    daemonState.s_t9 = (memaddr) code; /*Set t9 everytime we set PC*/
+    daemonState.s_sp = topRAM - (stackPg * PAGESIZE);
+    daemonState.s_status = ALLOFF | IEPON | IMON | TEBITON; /*kernel mode + interrupts enabled*/
+    if (SYSCALL(SYS1, (int)&daemonState, (int)NULL, 0) != 0){
+        get_nuked(NULL); /*terminate if SYS1 fails*/
+    }
+}
+
+/**************************************************************************************************
+ * @brief Empties the cache and the read-ahead streams, and launches the flush and read-ahead
+ * daemons. Called by test() after initDiskSched()
+ **************************************************************************************************/
+void initDiskCache(){
+    int i;
+    int d;
+
+    for (i = 0; i < DCACHESLOTS; i++){
+        dcache[i].dc_disk = FREE;
+        dcache[i].dc_sector = FREE;
+        dcache[i].dc_dirty = FALSE;
+        dcache[i].dc_busy = FALSE;
+        dcache[i].dc_waiters = 0;
+        dcache[i].dc_sema4 = 0;
+        dcache[i].dc_lastUse = 0;
+    }
+    dcacheSema4 = 1;
+    dcacheClock = 0;
+    dirtyCnt = 0;
+    idleWaiters = 0;
+    idleSema4 = 0;
+    flushSema4 = 0;
+    flushPending = FALSE;
+    for (i = 0; i <= MAXUPROCS; i++){
+        for (d = 0; d < DEV_UNITS; d++){
+            raLast[i][d] = FREE;
+            raNext[i][d] = 0;
+        }
+    }
+    raHead = 0;
+    raCount = 0;
+    raSema4 = 0;
+
+#if DISKCACHE
+    launch_daemon(diskFlusher, DISKFLUSHSTACKPG);
+#if DISKREADAHEAD
+    launch_daemon(diskReadAhead, DISKRASTACKPG);
+#endif
+#endif
+}
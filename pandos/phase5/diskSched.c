@@ -0,0 +1,229 @@
+/**************************************************************************************************
+ * @file diskSched.c
+ *
+ * @brief
+ * This module implements the per-disk request queues that order SYS14/SYS15 (disk_put/disk_get in
+ * deviceSupportDMA.c). A request names the cylinder it needs; while the disk is serving another
+ * request it waits in the disk's queue, and when the disk is released the next request is chosen
+ * by the scheduling policy selected at build time with DISKSCHED (const.h / make DISKSCHED=...):
+ *      DISK_FIFO  - arrival order (what the device semaphore alone used to give)
+ *      DISK_CLOOK - C-LOOK elevator: the nearest cylinder at or beyond the head, sweeping upwards;
+ *                   past the last request the head jumps back to the lowest queued cylinder
+ *
+ * @details
+ * The driver loop is run by the requesting processes themselves: disk_acquire() returns once the
+ * disk is handed to the caller, which issues its own SEEK and READBLK/WRITEBLK (the DMA buffer is
+ * copied in the caller's address space) and then calls disk_release(), which picks the next
+ * request and hands the disk over to it directly. The device semaphore (devSema4_support[diskNo])
+ * only guards the queue; each queued request waits on its own semaphore.
+ * A request queued for the cylinder under the head after the current request was dispatched waits
+ * for the next sweep, so a stream of requests on one cylinder cannot starve the others.
+ *
+ * The owner of a disk moves its head with disk_seek(), which remembers where each head was left
+ * and, with SEEKELIDE on, leaves out the SEEK (and its interrupt and context switch) when the head
+ * is already on the cylinder. A failed command, or a reset of the disk, makes the position
+ * unknown (disk_head_lost()), so the next request seeks again.
+ *
+ * @authors
+ * Nicolas & Tran
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project
+ **************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/sysSupport.h"
+#include "../h/diskSched.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+HIDDEN diskreq_t diskQueue[DEV_UNITS][DISKQLEN]; /*request slots of each disk*/
+HIDDEN int diskBusy[DEV_UNITS];                  /*TRUE while a request owns the disk*/
+HIDDEN int diskHead[DEV_UNITS];                  /*cylinder of the request being (or last) served*/
+HIDDEN unsigned int diskSeq[DEV_UNITS];          /*requests queued so far (arrival order)*/
+HIDDEN unsigned int sweepSeq[DEV_UNITS];         /*diskSeq when the current request was dispatched*/
+HIDDEN int headCyl[DEV_UNITS];                   /*cylinder the head was left on by the last SEEK, FREE if unknown*/
+HIDDEN int diskSlots[DEV_UNITS];                 /*counting semaphore: request slots not spoken for*/
+diskstats_t diskStats[DEV_UNITS];                /*per disk counters, reported by test()*/
+
+/**************************************************************************************************
+ * @brief Empties the request queues and resets the counters. Called by test() before the u-procs
+ * are launched
+ **************************************************************************************************/
+void initDiskSched(){
+    int d;
+    int i;
+
+    for (d = 0; d < DEV_UNITS; d++){
+        diskBusy[d] = FALSE;
+        diskHead[d] = 0;
+        diskSeq[d] = 0;
+        sweepSeq[d] = 0;
+        headCyl[d] = FREE; /*not seeked yet*/
+        diskSlots[d] = DISKQLEN;
+        diskStats[d].ds_requests = 0;
+        diskStats[d].ds_queued = 0;
+        diskStats[d].ds_seekDist = 0;
+        diskStats[d].ds_seeks = 0;
+        diskStats[d].ds_seekSkip = 0;
+        diskStats[d].ds_hits = 0;
+        diskStats[d].ds_misses = 0;
+        diskStats[d].ds_writebacks = 0;
+        diskStats[d].ds_readahead = 0;
+        for (i = 0; i < DISKQLEN; i++){
+            diskQueue[d][i].dr_state = DR_FREE;
+            diskQueue[d][i].dr_sema4 = 0;
+        }
+    }
+}
+
+/**************************************************************************************************
+ * @brief Records that a request for cylinder cyl now owns the disk. Called with the queue locked
+ **************************************************************************************************/
+HIDDEN void dispatch(int diskNo, int cyl){
+    diskStats[diskNo].ds_requests++;
+    diskStats[diskNo].ds_seekDist += (cyl > diskHead[diskNo]) ? (cyl - diskHead[diskNo]) : (diskHead[diskNo] - cyl);
+    diskHead[diskNo] = cyl;
+    sweepSeq[diskNo] = diskSeq[diskNo];
+}
+
+/**************************************************************************************************
+ * @brief Whether queued request a should be served before b (FREE: none yet)
+ **************************************************************************************************/
+HIDDEN int before(diskreq_t *queue, int a, int b){
+    if (b == FREE){
+        return TRUE;
+    }
+#if DISKSCHED == DISK_CLOOK
+    if (queue[a].dr_cyl != queue[b].dr_cyl){
+        return queue[a].dr_cyl < queue[b].dr_cyl;
+    }
+#endif
+    return queue[a].dr_seq < queue[b].dr_seq;
+}
+
+/**************************************************************************************************
+ * @brief Picks the next request to serve on a disk. Called with the queue locked
+ *
+ * @return: index of the request in the disk's queue, or FREE if the queue is empty
+ **************************************************************************************************/
+HIDDEN int next_request(int diskNo){
+    diskreq_t *queue = diskQueue[diskNo];
+    int ahead = FREE; /*at or beyond the head, on this sweep*/
+    int wrap = FREE;  /*for the next sweep*/
+    int i;
+
+    for (i = 0; i < DISKQLEN; i++){
+        if (queue[i].dr_state != DR_WAITING){
+            continue;
+        }
+#if DISKSCHED == DISK_CLOOK
+        if (queue[i].dr_cyl > diskHead[diskNo] ||
+            (queue[i].dr_cyl == diskHead[diskNo] && queue[i].dr_seq <= sweepSeq[diskNo])){
+            if (before(queue, i, ahead)){
+                ahead = i;
+            }
+            continue;
+        }
+#endif
+        if (before(queue, i, wrap)){
+            wrap = i;
+        }
+    }
+    return (ahead != FREE) ? ahead : wrap;
+}
+
+/**************************************************************************************************
+ * @brief Gets exclusive use of a disk for one request on cylinder cyl: immediately if the disk is
+ * idle, otherwise after waiting in its queue until disk_release() hands the disk over.
+ * A caller first takes one of the disk's DISKQLEN slots (diskSlots), so the queue cannot overflow:
+ * DISKQLEN covers the u-procs and the daemons, any caller beyond that waits for a slot to be freed
+ *
+ * @param: diskNo - disk device number; cyl - cylinder the request seeks to
+ * @return: None (the caller owns the disk until it calls disk_release())
+ **************************************************************************************************/
+void disk_acquire(int diskNo, int cyl){
+    diskreq_t *req;
+    int i;
+
+    SYSCALL(SYS3, (memaddr)&diskSlots[diskNo], 0, 0); /*reserve a slot*/
+    SYSCALL(SYS3, (memaddr)&devSema4_support[diskNo], 0, 0); /*lock the queue*/
+    if (!diskBusy[diskNo]){
+        diskBusy[diskNo] = TRUE;
+        dispatch(diskNo, cyl);
+        SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+        SYSCALL(SYS4, (memaddr)&diskSlots[diskNo], 0, 0); /*not queued: give the slot back*/
+        return;
+    }
+
+    /*Queue the request in a free slot (the reservation guarantees there is one)*/
+    for (i = 0; (i < DISKQLEN) && (diskQueue[diskNo][i].dr_state != DR_FREE); i++){
+        ;
+    }
+    if (i == DISKQLEN){
+        PANIC(); /*more queued requests than reserved slots: the queue is corrupt*/
+    }
+    req = &diskQueue[diskNo][i];
+    req->dr_state = DR_WAITING;
+    req->dr_cyl = cyl;
+    req->dr_seq = ++diskSeq[diskNo];
+    diskStats[diskNo].ds_queued++;
+    SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+
+    SYSCALL(SYS3, (memaddr)&req->dr_sema4, 0, 0); /*wait for the disk to be handed over*/
+    req->dr_state = DR_FREE; /*only now: the slot's semaphore is back to 0*/
+    SYSCALL(SYS4, (memaddr)&diskSlots[diskNo], 0, 0); /*free the slot*/
+}
+
+/**************************************************************************************************
+ * @brief Ends the caller's use of a disk and hands it to the next request in scheduling order
+ *
+ * @param: diskNo - disk device number
+ * @return: None
+ **************************************************************************************************/
+void disk_release(int diskNo){
+    int next;
+
+    SYSCALL(SYS3, (memaddr)&devSema4_support[diskNo], 0, 0); /*lock the queue*/
+    next = next_request(diskNo);
+    if (next == FREE){
+        diskBusy[diskNo] = FALSE;
+    }
+    else{
+        diskQueue[diskNo][next].dr_state = DR_DISPATCHED;
+        dispatch(diskNo, diskQueue[diskNo][next].dr_cyl);
+        SYSCALL(SYS4, (memaddr)&diskQueue[diskNo][next].dr_sema4, 0, 0);
+    }
+    SYSCALL(SYS4, (memaddr)&devSema4_support[diskNo], 0, 0);
+}
+
+/**************************************************************************************************
+ * @brief Moves the head of a disk to cylinder cyl. Called by the disk's owner (between
+ * disk_acquire() and disk_release()). When the last SEEK left the head on cyl nothing is issued
+ *
+ * @param: diskNo - disk device number; cyl - target cylinder
+ * @return: READY, or the device status of the failed SEEK
+ **************************************************************************************************/
+int disk_seek(int diskNo, int cyl){
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    int status;
+
+    if (SEEKELIDE && headCyl[diskNo] == cyl){
+        diskStats[diskNo].ds_seekSkip++;
+        return READY;
+    }
+
+    diskStats[diskNo].ds_seeks++;
+    setSTATUS(NO_INTS);
+    busRegArea->devreg[diskNo].d_command = (cyl << LEFTSHIFT8) | SEEK_CMD; /*issue SEEK command*/
+    status = SYSCALL(SYS5, DISKINT, diskNo, 0); /*Block until the SEEK completes*/
+    setSTATUS(YES_INTS);
+
+    headCyl[diskNo] = (status == READY) ? cyl : FREE;
+    return status;
+}
+
+/**************************************************************************************************
+ * @brief Forgets where the head of a disk is, after a failed command or a reset; the next request
+ * seeks
+ **************************************************************************************************/
+void disk_head_lost(int diskNo){
+    headCyl[diskNo] = FREE;
+}
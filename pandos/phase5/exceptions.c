@@ -44,6 +44,15 @@
  *   the current process is the process that requested to spend part of its time slice
  *   to handle the SYSCALL request, so it's logical to charge this time as part of the
  *   accumulated CPU time for the current process.
+ * - Interrupt handling time is charged to whichever process was running when the 
+ *   interrupt arrived, since nobody else is around to pay for it.
+ * - On top of the total (p_time), each pcb keeps the split (p_acct): its own code 
+ *   (ca_user), the Nucleus serving its SYSCALLs/pass ups (ca_sys), interrupts it was 
+ *   charged for (ca_intr) and its support level handlers (ca_support). The Nucleus 
+ *   entry charges the time since quantum to ca_user/ca_support (chargeRunTime()) and 
+ *   restarts quantum; every exit back to the process (or block) charges the handler 
+ *   time to ca_sys/ca_intr (chargeCpu()). SYS6 reports the split, support level SYS21 
+ *   hands it to u-procs.
  *  
  *  
  * @note  
@@ -63,13 +72,16 @@
  #include "../h/scheduler.h"
  #include "../h/exceptions.h"
  #include "../h/interrupts.h"
+#include "../h/trace.h"
  #include "../h/initial.h"
+#include "../h/vmSupport.h"
 
 #include "/usr/include/umps3/umps/libumps.h"
 
 HIDDEN void blockCurrProc(int *sem); /* Block the current process on the given semaphore (helper method) */
 int syscallNo; /*stores the syscall number (1-8)*/
-HIDDEN void recursive_terminate(pcb_PTR proc);
+HIDDEN void terminate_single(pcb_PTR proc);
+HIDDEN void terminate_tree(pcb_PTR root);
 
 #define EXCSTATE ((state_t *) BIOSDATAPAGE)
 
@@ -84,6 +96,30 @@ cpu_t get_elapsed_time() {
 	return clockTime - quantum; /*Return the elapsed time relative to the process's quantum*/
 }
 
+/*Helper method to charge the time since quantum to currProc, both to its total (p_time) and to one of its
+  p_acct buckets, and start a new accounting interval*/
+void chargeCpu(cpu_t *bucket){
+	cpu_t elapsed = get_elapsed_time();
+	currProc->p_time += elapsed;
+	*bucket += elapsed;
+	quantum += elapsed;
+}
+
+/*Helper method called on every Nucleus entry: the time since quantum was spent running currProc's own code,
+  which is support level handler code if it runs in kernel mode with a support structure*/
+void chargeRunTime(){
+	state_t *savedState = (state_t *) BIOSDATAPAGE;
+	if (currProc == NULL){
+		return; /*entered from WAIT - nobody to charge*/
+	}
+	if (((savedState->s_status & USERPON) == ALLOFF) && (currProc->p_supportStruct != NULL)){
+		chargeCpu(&(currProc->p_acct.ca_support));
+	}
+	else{
+		chargeCpu(&(currProc->p_acct.ca_user));
+	}
+}
+
 /*Helper method to copy 'len' bytes from the source memory block 'src' to the destination memory block 'dest' */
 void* memcpy(void *dest, const void *src, unsigned int len) {
 	char *d = dest;
@@ -97,43 +133,71 @@ void* memcpy(void *dest, const void *src, unsigned int len) {
 /*Helper method to block the currently running process (currProc) on a specified semaphore.*/
 void blockCurrProc(int *sem){
 	currProc->p_s = *((state_t *) BIOSDATAPAGE); /*get current processor state*/
-	currProc->p_time += get_elapsed_time(); /*update process's accumulated CPU time by adding elapsed time since quantum began*/
+	chargeCpu(&(currProc->p_acct.ca_sys)); /*update process's accumulated CPU time by adding elapsed time since quantum began*/
+	TRACE_EVENT(TR_BLOCK, sem, currProc);
 	insertBlocked((int *) sem, currProc); /*insert current proc into blocked queue associated with the given semaphore*/
 	currProc = NULL; /*reset currProc global variable*/
 }
 
-/*Recurisve function - helper to SYS2 terminateProcess()*/
-void recursive_terminate(pcb_PTR proc){
-	pcb_PTR child_proc; /*point to current child (pcb) of process to be terminated*/
-	int *processSem;
-	processSem = proc->p_semAdd;
+/*Helper to SYS2 terminateProcess() - tear down a single pcb that has no children left.
+  Which queue proc is on is known in O(1): it is either the running process, blocked
+  (p_semd points at its ASL descriptor) or, otherwise, on the Ready Queue*/
+void terminate_single(pcb_PTR proc){
+	int *processSem = proc->p_semAdd;
+
+	if (proc->p_semd != NULL){
+		/* Check if process p is blocked on a device semaphore.
+		   It is considered blocked on a device if its semaphore pointer (p->p_semAdd)
+		   falls within the range of deviceSemaphores[] or is equal to the address of semIntTimer. */
+		int blockedOnDevice =
+			((processSem >= deviceSemaphores) && (processSem < (deviceSemaphores + (DEVICE_TYPES * DEV_UNITS))))
+			|| (processSem == &semIntTimer);
+
+		outBlocked(proc); /* Remove p from its blocked queue (O(1) through p_semd) */
+
+		/* A device (or pseudo-clock) semaphore is V'ed by its interrupt, so only the soft-block
+		   count is adjusted. Otherwise, give back the unit that p's P operation took */
+		if (blockedOnDevice) {
+			softBlockCnt--;
+		}
+		else {
+			(*processSem)++;
+		}
+	}
+	else if (proc != currProc){
+		unreadyProc(proc); /* Not blocked and not running -> proc is on a Ready Queue */
+	}
 
-	/* Terminate all child processes of proc */
-    while ((child_proc = removeChild(proc)) != NULL) {
-        outProcQ(&ReadyQueue, child_proc);  /*Remove child from the Ready Queue*/
-        recursive_terminate(child_proc);       /*Recursively terminate the child process*/
-    }
+	/* Free the process control block for p and update the global process count */
+	freePcb(proc);
+	procCnt--;
+}
+
+/*Helper to SYS2 terminateProcess() - iterative post-order walk of the process tree rooted at root.
+  Descend through p_child to a leaf, detach it from its parent (outChild is O(1) on the doubly
+  linked sibling list) and kill it, then resume from its parent. Every pcb is visited a constant
+  number of times and no recursion is used, so the nucleus stack stays bounded whatever the tree shape*/
+void terminate_tree(pcb_PTR root){
+	pcb_PTR curr = root;
+	pcb_PTR parent;
+
+	while (TRUE) {
+		/* Descend to a leaf (a pcb without children) */
+		while (!emptyChild(curr)) {
+			curr = curr->p_child;
+		}
 
-	/* Check if process p is blocked on a device semaphore.
-       It is considered blocked on a device if its semaphore pointer (p->p_semAdd)
-       falls within the range of deviceSemaphores[] or is equal to the address of semIntTimer. */
-	   int blockedOnDevice = 
-	   ((processSem >= (int *) deviceSemaphores) &&
-		(processSem < ((int *) deviceSemaphores + (sizeof(int) * DEVICE_TYPES * DEV_UNITS))))
-		|| (processSem == (int *) &semIntTimer);
-
-   /* Remove p from its blocked queue (if it is currently blocked) */
-   pcb_PTR removedPcb = outBlocked(proc);
-
-   /* If the process was removed from a blocking queue and is not blocked on a device,
-	  then increment the associated semaphore value (signaling that a resource has been freed). */
-   if (!blockedOnDevice && removedPcb != NULL) {
-	   (*(processSem))++;
-   }
-
-   /* Free the process control block for p and update the global process count */
-   freePcb(proc);
-   procCnt--;
+		/* The root is the last leaf left */
+		if (curr == root) {
+			terminate_single(root);
+			return;
+		}
+
+		parent = curr->p_prnt;
+		outChild(curr);          /* detach leaf from its parent (and siblings) */
+		terminate_single(curr);
+		curr = parent;           /* continue with the parent's remaining children */
+	}
 }
 
 
@@ -149,7 +213,7 @@ void recursive_terminate(pcb_PTR proc){
  *  
  * 
  * @details  
- * - Allocates a new PCB using allocPcb()  
+ * - Allocates a new PCB using allocPcb() (pools sized at boot, initPools()).  
  * - If no PCB is available, sets v0 to -1 and returns.  
  * - Copies the state of the requesting process (stateSYS) into the new PCB.  
  * - Initializes process fields (support structure, CPU time, etc.).  
@@ -177,7 +241,7 @@ void createProcess(state_t *stateSYS, support_t *suppStruct) {
 		newProc->p_time = 0;              			 /* Initialize CPU time usage to 0 */
      
         insertChild(currProc, newProc);              /* Insert the new process as a child of the current process */
-        insertProcQ(&ReadyQueue, newProc);           /* Add the new process to the Ready Queue for scheduling */
+        readyProc(newProc);           /* Add the new process to the Ready Queue for scheduling */
 
         savedState->s_v0 = 0;                		 /* Indicate success (0) in the caller's v0 register */
         procCnt++;                                   /* Increment the active process count */
@@ -195,12 +259,13 @@ void createProcess(state_t *stateSYS, support_t *suppStruct) {
  *  
  * 
  * @brief  
- * Recursively terminates a process and all of its children, removing them  
+ * Terminates a process and all of its progeny, removing them  
  * from the system and freeing their PCBs.  
  *  
  * 
  * @details  
- * - If the process has children, it recursively terminates them first.  
+ * - The process tree is torn down iteratively in post-order (children before  
+ *   their parent) by terminate_tree(), in O(N) time and bounded stack space.  
  * - If the process is running (currProc), it is detached from its parent.  
  * - If the process is blocked, it is removed from the ASL.  
  * - If the process is waiting on a device semaphore, it decrements softBlockCnt.  
@@ -215,7 +280,7 @@ void createProcess(state_t *stateSYS, support_t *suppStruct) {
  *****************************************************************************/
 void terminateProcess() {
     outChild(currProc);
-	recursive_terminate(currProc);
+	terminate_tree(currProc);
 	currProc = NULL;
 	switchProcess();
 }
@@ -278,7 +343,10 @@ pcb_PTR verhogen(int *sem) {
 
     if (*sem <= 0) { 
         p = removeBlocked(sem); /* Unblock the first process waiting on this semaphore */
-		if (p != NULL){insertProcQ(&ReadyQueue,p);}    /* Add the unblocked process to the Ready Queue */
+		if (p != NULL){
+			TRACE_EVENT(TR_UNBLOCK, sem, p);
+			readyProc(p);    /* Add the unblocked process to the Ready Queue */
+		}
     }
     return p; /*return pointer to unblocked process pcb*/
 }
@@ -293,6 +361,7 @@ pcb_PTR verhogen(int *sem) {
  *  
  * @details  
  * - Computes the semaphore index for the given device.  
+ * - Under the MLFQ scheduler, promotes the process one level (it is I/O bound).  
  * - If the device is a terminal, determines if it's a read or write request.  
  * - The process performs a P operation on the device semaphore.  
  * - The process is blocked and inserted into the ASL.  
@@ -336,37 +405,47 @@ void waitForIO(int lineNum, int deviceNum, int readBool) {
         return;
     }
 	int index = semIndex * DEVPERINT + deviceNum;
+    promoteProc(currProc); /*MLFQ: a process giving up the CPU for I/O moves up a level*/
     /*Perform the "passeren" (P or wait) operation on the chosen device semaphore.*/
     passeren(&deviceSemaphores[index]);
 }
 
 /****************************************************************************  
- * getCPUTime() - SYS6  
+ * getCPUTimeSplit() - SYS6  
  *  
  * @brief  
  * Returns the total CPU time used by the calling process.  
+ * If a1 is not 0, it is the address of a cpuacct_t that is filled with the  
+ * split of that time (user / SYSCALL / interrupt / support level).  
  *  
  * @details  
- * - The process's CPU time is stored in its PCB (p_time).  
+ * - The process's CPU time is stored in its PCB (p_time, split in p_acct).  
+ * - The SYSCALL in progress counts as Nucleus (ca_sys) time.  
  * - The function reads the current Time of Day (TOD) clock and calculates  
  *   the time since the process last started executing.  
  * - The result is returned in the v0 register.  
  *  
  * @return None (CPU time is stored in v0).  
  *****************************************************************************/
-void getCPUTime(state_t *savedState){
+void getCPUTimeSplit(state_t *savedState, cpuacct_t *acct){
 	cpu_t totalTime;
-    totalTime = currProc->p_time + get_elapsed_time();
+	chargeCpu(&(currProc->p_acct.ca_sys)); /*bring the accounting up to date*/
+    totalTime = currProc->p_time;
 	savedState->s_v0 = totalTime;
+	if (acct != (cpuacct_t *) 0){
+		*acct = currProc->p_acct;
+	}
     currProc->p_s.s_v0 = totalTime;
 }
 
 
 /****************************************************************************  
- * waitForClock() - SYS7  
+ * waitForClockUntil() - SYS7  
  *  
  * @brief  
  * Blocks the calling process until the next interval timer interrupt occurs.  
+ * a1 tells the tickless idle what the caller really needs: CLOCKNEXTTICK (0) for  
+ * the next 100ms tick, otherwise the TOD by which it must run again.  
  *  
  * @details  
  * - Performs a P operation on the clock semaphore (decrement semaphore by 1)  
@@ -376,8 +455,9 @@ void getCPUTime(state_t *savedState){
  *  
  * @return None  
  *****************************************************************************/
-void waitForClock() {
+void waitForClockUntil(cpu_t deadline) {
 	softBlockCnt++;
+	clockWaitNote(deadline); /*record what the waiter needs, for tickless idle*/
 	passeren(&semIntTimer);
 }
 
@@ -413,7 +493,7 @@ void getSupportData(state_t *savedState) {
  *   to the corresponding user-defined handler.  
  * - The function copies the saved processor state from the BIOS Data Page into  
  *   the appropriate exception state field of the process's support structure.  
- * - CPU time used up to the exception is recorded and charged to the process.  
+ * - CPU time used up to the exception is recorded and charged to the process (ca_sys).  
  * - The process context is then switched to the user-level exception handler.  
  * - If the process does not have a support structure, it is terminated  
  *   along with any of its child processes.  
@@ -428,6 +508,7 @@ void exceptionPassUpHandler(int exceptionCode) {
 	if (currProc->p_supportStruct != NULL){
 		copyState(((state_t *) BIOSDATAPAGE),&(currProc->p_supportStruct->sup_exceptState[exceptionCode]));
 		context_t *ctx = &(currProc->p_supportStruct->sup_exceptContext[exceptionCode]);
+		chargeCpu(&(currProc->p_acct.ca_sys)); /*the Nucleus part of the pass up*/
 		LDCXT(ctx->c_stackPtr, ctx->c_status, ctx->c_pc);
 	}
 	/* No user-level handler defined, so terminate the process */
@@ -470,7 +551,10 @@ void prgmTrapHandler() {
  * 
  * @details  
  * - This function is called when a Page Fault Exception occurs.  
- * - Instead of handling the exception directly, it delegates the handling  
+ * - Soft faults on resident pages (V bit cleared for reference sampling,
+ *   page on the reclaim list, first store to a clean page) are resolved
+ *   right here by tlb_fast_path() when the swap pool is not locked.
+ * - Otherwise, instead of handling the exception directly, it delegates the handling  
  *   to exceptionPassUpHandler(), which determines whether the process  
  *   has a user-defined exception handler using the PGFAULTEXCEPT index value
  * - If a handler exists, the exception state is passed up to user space.  
@@ -480,6 +564,15 @@ void prgmTrapHandler() {
  * @return None  
  *****************************************************************************/ 
 void tlbTrapHanlder() {
+	if (currProc->p_supportStruct != NULL){
+		STCK(currProc->p_supportStruct->sup_faultTOD); /*soft fault service times are measured from here*/
+#if FASTPATH
+		if (tlb_fast_path(currProc->p_supportStruct)){ /*resident page: fixed without passing up*/
+			chargeCpu(&(currProc->p_acct.ca_sys));
+			LDST(EXCSTATE);
+		}
+#endif
+	}
 	exceptionPassUpHandler(PGFAULTEXCEPT);
 }
 
@@ -516,6 +609,8 @@ void sysTrapHandler() {
 	unsigned int reg_a2 = savedState->s_a2;
 	unsigned int reg_a3 = savedState->s_a3;
 
+	TRACE_EVENT(TR_SYSCALL, syscallNo, currProc);
+
 	/*Increment PC by 4 avoid infinite loops*/
     savedState->s_pc = savedState->s_pc + WORDLEN;
 
@@ -551,10 +646,10 @@ void sysTrapHandler() {
 			waitForIO(reg_a1, reg_a2, reg_a3);
 			break;
 		case SYS6:
-			getCPUTime(savedState);
+			getCPUTimeSplit(savedState, (cpuacct_t *) reg_a1);
 			break;
 		case SYS7:
-			waitForClock();
+			waitForClockUntil((cpu_t) reg_a1);
 			break;
 		case SYS8:
 			getSupportData(savedState);
@@ -571,9 +666,12 @@ void sysTrapHandler() {
      */
 	if (currProc == NULL)
 		switchProcess();
-	else
+	else{
+		TRACE_EVENT(TR_SYSRET, syscallNo, currProc);
+		chargeCpu(&(currProc->p_acct.ca_sys)); /*SYSCALL time is charged to the caller*/
 		LDST(savedState);
 	}
+	}
 	else {
 	/* 
      * If kup_check is not 0, the process is not in kernel mode
@@ -615,6 +713,7 @@ void gen_exception_handler()
     int exception_code; /* Stores the extracted exception type */  
 
     saved_state = (state_t *) BIOSDATAPAGE;  /* Retrieve the saved processor state from BIOS data page */
+	chargeRunTime(); /* Charge the time up to here to the running process' own code, start timing the Nucleus */
     exception_code = ((saved_state->s_cause) & GETEXCPCODE) >> CAUSESHIFT; /* Extract exception code from the cause register */
 
 	if (exception_code == 0) {  
@@ -30,6 +30,10 @@
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"
 #include "../h/delayDaemon.h"
+#include "../h/pageCleaner.h"
+#include "../h/diskSched.h"
+#include "../h/diskCache.h"
+#include "../h/trace.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /* DECLARE VARIABLES & DATA STRUCTURES */
@@ -164,13 +168,17 @@ void summon_process(int process_id, state_t *base_state){
 
     /*Entry 31 of page table = stack*/
     suppStruct->sup_privatePgTbl[PAGE_TABLE_MAX].entryHI = PAGE31_ADDR + (process_id << SHIFT_ASID); /*pandos - 4.2.1*/
-    suppStruct->sup_privatePgTbl[PAGE_TABLE_MAX].entryLO = D_BIT_SET; /*mark D bit on*/
+#if ZEROFILL
+    suppStruct->sup_privatePgTbl[PAGE_TABLE_MAX].entryLO = ZEROFILL_BIT; /*not in the flash image: the Pager zeroes it on the first touch, mapped clean*/
+#else
+    suppStruct->sup_privatePgTbl[PAGE_TABLE_MAX].entryLO = ALLOFF; /*clean: the first store sets D via the TLB-Modification exception*/
+#endif
 
-    /*The other entries 0-30 are initialized the same way*/
+    /*The other entries 0-30 are initialized the same way (those past the image turn zero-fill once the Pager reads the .aout header)*/
     int k;
     for (k=0; k < PAGE_TABLE_MAX; k++){
         suppStruct->sup_privatePgTbl[k].entryHI = PT_START + (k << SHIFT_VPN) + (process_id << SHIFT_ASID); /*pandos - 4.2.1*/
-        suppStruct->sup_privatePgTbl[k].entryLO = D_BIT_SET; /*mark the page as dirty by default - each page will be write-enabled*/
+        suppStruct->sup_privatePgTbl[k].entryLO = ALLOFF; /*pages are mapped clean; the Pager write-enables them on the first store*/
     }
 
     /*Call SYS1 to create and launch the u-proc*/
@@ -207,10 +215,13 @@ void test() {
 
     initSuppPool(); /*Initialize support structs free pool*/
     initSwapStructs(); /*Initialize swap pool table, swap pool semaphore and associated device semaphores - function in vmSupport.c*/
+    initDiskSched(); /*empty the disk request queues (SYS14/SYS15 scheduling)*/
+    initDiskCache(); /*empty the disk block cache, launch its flush daemon (make DISKCACHE=0 to leave it out)*/
  
     /*Set up initial proccessor state*/
     init_base_state(&base_state);
     initADL(); /*PHASE 5 to initialize ADL*/
+    initPageCleaner(); /*launch the page cleaner daemon (make PAGECLEANER=0 to leave it out)*/
 
     /*create and launch 8 user processes*/
     /*note: asid (process_id) 0 is reserved for kernl daemons, so the (up to 8) u-procs get assigned asid values from 1-8 instead*/
@@ -225,6 +236,45 @@ void test() {
         SYSCALL(SYS3, (memaddr) &masterSema4, 0, 0);
     }
 
+    dcache_sync(); /*the u-procs are done: put the cached sectors on the disks*/
+
+    /*Report the pager counters for the run (breakpoint on debug_fxn, or print7.umps with make TRACE=1)*/
+    debug_fxn(DBG_VMSTATS, vmStats.vm_faults, vmStats.vm_refaults, vmStats.vm_evictions);
+    TRACE_EVENT(TR_VMSTATS, vmStats.vm_faults, vmStats.vm_evictions);
+    TRACE_EVENT(TR_VMWRITES, vmStats.vm_writebacks, vmStats.vm_refaults);
+    TRACE_EVENT(TR_VMREADAHEAD, vmStats.vm_readahead, vmStats.vm_faults);
+    TRACE_EVENT(TR_VMRECLAIM, vmStats.vm_reclaims, vmStats.vm_faults);
+    TRACE_EVENT(TR_VMZEROFILL, vmStats.vm_zerofills, vmStats.vm_faults);
+    for (i = 0; i < VMLATBUCKETS; i++){
+        TRACE_EVENT(TR_VMLAT, i, vmStats.vm_latHist[i]);
+    }
+    for (i = 0; i < DEV_UNITS; i++){
+        TRACE_EVENT(TR_VMSWAPDEV, i, vmStats.vm_swapDev[i]);
+    }
+    for (i = 1; i <= MAXUPROCS; i++){
+        TRACE_EVENT(TR_VMASID, i, vmStats.vm_asidFaults[i]);
+        TRACE_EVENT(TR_VMASIDSOFT, i, vmStats.vm_asidSoft[i]);
+    }
+    debug_fxn(DBG_CLEANER, vmStats.vm_cleaned, vmStats.vm_writebacks, vmStats.vm_latMax);
+    TRACE_EVENT(TR_VMFASTPATH, vmStats.vm_fastFaults, (vmStats.vm_fastFaults == 0) ? 0 : vmStats.vm_fastTime / vmStats.vm_fastFaults);
+    TRACE_EVENT(TR_VMSLOWSOFT, vmStats.vm_slowSoft, (vmStats.vm_slowSoft == 0) ? 0 : vmStats.vm_slowSoftTime / vmStats.vm_slowSoft);
+    debug_fxn(DBG_FASTPATH, vmStats.vm_fastFaults, vmStats.vm_slowSoft, vmStats.vm_fastTime);
+    for (i = 0; i < DEV_UNITS; i++){
+        if (diskStats[i].ds_requests > 0){
+            TRACE_EVENT(TR_DISKSTATS, i, diskStats[i].ds_requests);
+            TRACE_EVENT(TR_DISKSEEK, i, diskStats[i].ds_seekDist / diskStats[i].ds_requests);
+            debug_fxn(DBG_DISKSCHED, i, diskStats[i].ds_requests, diskStats[i].ds_seekDist);
+            TRACE_EVENT(TR_DISKELIDE, i, diskStats[i].ds_seekSkip);
+            debug_fxn(DBG_SEEKELIDE, i, diskStats[i].ds_seeks, diskStats[i].ds_seekSkip);
+        }
+        if (diskStats[i].ds_hits + diskStats[i].ds_misses > 0){
+            TRACE_EVENT(TR_DCACHEHIT, i, diskStats[i].ds_hits);
+            TRACE_EVENT(TR_DCACHEMISS, i, diskStats[i].ds_misses);
+            TRACE_EVENT(TR_DCACHERA, i, diskStats[i].ds_readahead);
+            debug_fxn(DBG_DCACHE, i, diskStats[i].ds_hits, diskStats[i].ds_misses);
+        }
+    }
+
     /* Terminate the instantiator process */
     SYSCALL(SYS2, 0, 0, 0);
 }
@@ -22,9 +22,9 @@
  * In detail, the initial.c module accomplishes the following:
  * - Declare Level 3 global variables
  * - Populate Processor0 Pass-Up Vector
- * - Initalize Level 2 Data Structures - Active Semaphore List and Free PCB List
+ * - Initalize Level 2 Data Structures - Active Semaphore List and Free PCB List, sized at boot from the installed RAM
  * - Initialize all Nucleus maintained variables: Process Count (0), Soft-block Count (0), 
- *              Ready Queue (mkEmptyProcQ()), and Current Process (NULL), device semaphores (all set to zero)
+ *              Ready Queue(s) (initReadyQueues()), and Current Process (NULL), device semaphores (all set to zero)
  * - Configure System-wide Interval Timer 
  * - Create the first process
  * - Launch the first process and pass control to the Scheduler (scheduler.c)
@@ -57,10 +57,11 @@ extern void uTLB_RefillHandler(); /*support level TLB refill event handler*/
 /*************GLOBAL VARIABLES DECLARATIONS*********************/
 int procCnt; /*integer indicating the number of started, but not yet terminated processes.*/
 int softBlockCnt; /*Integer representing the number of started, but not terminated processes that in are the “blocked” state due to an I/O or timer request.*/
-pcb_PTR ReadyQueue; /*Tail pointer to a queue of pcbs that are in the “ready” state.*/
 pcb_PTR currProc; /*Pointer to the pcb that is in the “running” state, i.e. the current executing process.*/
 int deviceSemaphores[DEVICE_TYPES * DEV_UNITS]; /* semaphore integer array that represents each external (sub) device, plus one semd for the Pseudo-clock */
 int semIntTimer; /* semaphore used by the interval timer (pseudo-clock) for timer-related blocking operations */
+int procCap; /* number of pcbs (and semaphore descriptors) carved at boot, i.e. how many processes SYS1 can create */
+memaddr kernPoolEnd; /* page aligned end of the pools; RAM above it, up to the stacks, is left to the swap pool */
 
 /***********************HELPER METHODS***************************************/
 
@@ -131,6 +132,79 @@ void populate_passUpVec(){
     proc0_passup_vec->exception_stackPtr = TOPSTKPAGE;                      /*Set the Stack pointer for the Nucleus exception handler to the top of the Nucleus stack page*/
 }
 
+/****************************************************************************
+ * initPools()
+ * 
+ * 
+ * @brief 
+ * Sizes the pcb and semaphore descriptor pools from the installed RAM and 
+ * carves them out of the reserved kernel region that starts at KERNPOOLSTART.
+ * 
+ * 
+ * @protocol 
+ * 1. The region may use 1/POOLRAMDIV of RAM (ramsize field of the bus register 
+ *    area), and must stop KERNSTACKPAGES pages below RAMTOP, where the stacks live.
+ * 2. Each process costs one pcb, one semaphore descriptor and at most two ASL hash 
+ *    bucket heads; that gives procCap (capped at MAXPROCCAP).
+ * 3. The ASL bucket array (power of 2 >= procCap) is carved first, then all the 
+ *    pcbs/descriptors. POOLRAMDIV and MAXPROCCAP are build knobs (make POOLRAMDIV=n).
+ * 4. If RAM is too small to hold even MAXPROC processes, the static pools of 
+ *    initPcbs()/initASL() are used instead.
+ * 5. The chosen capacity is reported in procCap and through debug_fxn.
+ * 6. kernPoolEnd records where the pools end; the Support Level's swap pool 
+ *    (vmSupport.c) takes the RAM from there to the stacks.
+ * 
+ * 
+ * @param None
+ * @return None
+ *****************************************************************************/
+void initPools(){
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    memaddr stackFloor = busRegArea->rambase + busRegArea->ramsize - (KERNSTACKPAGES * PAGESIZE); /*lowest address the stacks may reach*/
+    memaddr poolEnd = KERNPOOLSTART + (busRegArea->ramsize / POOLRAMDIV); /*end of the reserved kernel pool region*/
+    unsigned int procSize = sizeof(pcb_t) + sizeof(semd_t) + (2 * sizeof(semd_PTR)); /*bytes of pool needed per process*/
+    semd_PTR *buckets;
+    pcb_PTR pcbs;
+    semd_PTR semds;
+    int bucketCnt;
+
+    if (poolEnd > stackFloor){
+        poolEnd = stackFloor;
+    }
+    procCap = (poolEnd > KERNPOOLSTART) ? (poolEnd - KERNPOOLSTART) / procSize : 0;
+    if (procCap > MAXPROCCAP){
+        procCap = MAXPROCCAP;
+    }
+
+    /*Not even MAXPROC processes fit -> fall back on the static pools*/
+    if (procCap < MAXPROC){
+        initPcbs();
+        initASL();
+        procCap = MAXPROC;
+        kernPoolEnd = KERNPOOLSTART;
+        debug_fxn(DBG_POOLCAP, procCap, 0, POOLRAMDIV);
+        return;
+    }
+
+    /*Carve the ASL hash buckets, then the pcbs and semaphore descriptors*/
+    bucketCnt = 1;
+    while (bucketCnt < procCap){
+        bucketCnt <<= 1;
+    }
+    buckets = (semd_PTR *) KERNPOOLSTART;
+    pcbs = (pcb_PTR) (KERNPOOLSTART + (bucketCnt * sizeof(semd_PTR)));
+    semds = (semd_PTR) (((memaddr) pcbs) + (procCap * sizeof(pcb_t)));
+
+    initPcbPool(pcbs, procCap);
+    initASLPool(semds, procCap, buckets, bucketCnt);
+
+    /*The rest of the region, up to the stacks, is handed to the swap pool*/
+    kernPoolEnd = ((memaddr) semds) + (procCap * sizeof(semd_t));
+    kernPoolEnd = ((kernPoolEnd + PAGESIZE - 1) / PAGESIZE) * PAGESIZE;
+
+    debug_fxn(DBG_POOLCAP, procCap, bucketCnt, POOLRAMDIV); /*report the chosen capacity*/
+}
+
 /****************************************************************************
  * init_proc_state()
  * 
@@ -191,7 +265,7 @@ void init_proc_state(pcb_PTR firstProc){
  * @protocol 
  * The following steps are performed:
  *  1. Declare variables
- *  2. Initialize Level 2 data structures
+ *  2. Initialize Level 2 data structures (pools sized from RAMBASESIZE by initPools())
  *  3. Initialize Pass Up Vector fields for exceptions and TLB-refill events
  *      - Set the Nucleus TLB-Refill event handler address
  *      - Set Stack Pointer for Nucleus TLB-Refill event handler to top of Nucleus stack page
@@ -222,14 +296,13 @@ int main() {
 	/*Initialize device semaphores (array declared as extern so values are zero-initialized)*/
 
     /*Initialize variables*/
-    ReadyQueue = mkEmptyProcQ();  /*Initialize the Ready Queue*/
+    initReadyQueues();  /*Initialize the Ready Queue(s) - owned by the scheduler*/
     currProc = NULL;  /*No process is running initially */
     procCnt = INITPROCCNT;  /*No active processes yet*/
     softBlockCnt = INITSBLOCKCNT;  /*No soft-blocked processes*/
 
 	/*Initialize Level 2 data structures*/
-	initPcbs(); /*Set up the Process Control Block (PCB) free list (pool of avaible pcbs)*/
-	initASL(); /*Set up the Active Semaphore List (ASL)*/
+	initPools(); /*Size the PCB free list (pool of avaible pcbs) and the Active Semaphore List (ASL) from the installed RAM*/
 
 	/*Initialize passUp vector fields*/
     populate_passUpVec();
@@ -243,7 +316,7 @@ int main() {
 	if (first_proc != NULL){
 		procCnt++; /*increment process count*/
 		init_proc_state(first_proc); /* Initialize the process state for the new process (stack, PC, t9, status) */
-		insertProcQ(&ReadyQueue, first_proc); /* Insert the new process into the ready queue */
+		readyProc(first_proc); /* Insert the new process into the ready queue */
 		switchProcess();  /* Invoke the scheduler */
 		return 1;
 	}
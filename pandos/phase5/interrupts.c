@@ -24,25 +24,18 @@
  *   remaining lower-priority interrupts.
  * 
  * @cpu_time_accounting
- * A key decision in this module is how*CPU time is charged when handling interrupts:
- * - I/O Interrupts (Lines 3-7)  
- *   - The CPU time spent handling an I/O interrupt is charged to the process that  
- *     generated the interrupt, rather than the process that was running when the  
- *     interrupt occurred. We made this decision because it is appropriate to charge
- *     the process that generated the interrupt CPU time instead of penalizing the
- *     process that was running when the interrupt occurred.
- * 
- * 
- * - Handling Process Local Timer (PLT) Interrupts  
- *   - The time between when the Current Process began executing and when the PLT  
- *     interrupt occurred is charged to the Current Process.
- *   - Additionally, the time spent **handling the PLT interrupt** is also charged to  
- *     the Current Process, since it was responsible for exhausting its time slice.
- * 
- * - Handling System-wide Interval Timer Interrupt  
- *   - The Current Process is charged for the time it executed before the interrupt.  
- *   - However, the time spent handling the interrupt is not charged to any  
- *     process, since it is a global system event, not directly caused by any process.
+ * Interrupt handling time is charged to the interrupted process (ca_intr):
+ * - The Nucleus entry first charges the time the Current Process ran up to the  
+ *   interrupt to its own code (ca_user, or ca_support inside its support level).
+ * - The time then spent in this module is charged to the same Current Process,  
+ *   in its ca_intr bucket, whatever line raised the interrupt:
+ *   - I/O Interrupts (Lines 3-7), even though the request being completed  
+ *     usually belongs to another process.
+ *   - Process Local Timer (PLT) Interrupts, since it exhausted its time slice.
+ *   - System-wide Interval Timer Interrupts.
+ * - Keeping it in ca_intr (separate from ca_user/ca_sys) lets SYS6 report how  
+ *   much of a process' p_time was really other processes' interrupt work.
+ * - If no process was running (WAIT), the handling time is charged to nobody.
  * 
  * @authors
  * - Nicolas & Tran
@@ -57,6 +50,7 @@
  #include "../h/scheduler.h"
  #include "../h/exceptions.h"
  #include "../h/interrupts.h"
+#include "../h/trace.h"
  #include "../h/initial.h"
  
  #include "/usr/include/umps3/umps/libumps.h"
@@ -139,6 +133,7 @@
 	 }
 	 device_intMap = mask;  /*device_intMap contains only the lowest set bit*/
 	 int deviceInstance = getInterruptLine(device_intMap);
+	 TRACE_EVENT(TR_INTR, deviceType + OFFSET, deviceInstance);
  
 	 /*Case 1: Interrupt device is not terminal devs*/
 	 if (deviceType != 4){
@@ -185,6 +180,7 @@
 	 }
 	 state_PTR savedState = (state_t *) BIOSDATAPAGE;
 	 if (currProc != NULL){
+		 chargeCpu(&(currProc->p_acct.ca_intr)); /* Interrupt handling time is charged to the interrupted process */
 		 LDST(savedState);
 	 }
 	 switchProcess();
@@ -203,7 +199,8 @@
   *   1. Acknowledges the interrupt by resetting the timer.  
   *   2. Saves the current process state (from the BIOS Data Page).  
   *   3. Updates the CPU time used by the current process.  
-  *   4. Moves the current process back to the Ready Queue.  
+  *   4. Moves the current process back to the Ready Queue (one level 
+  *      lower under the MLFQ scheduler, as it burned its whole slice).  
   *   5. Calls the scheduler to select the next process to run.  
   * - If no process is running, this function triggers a kernel panic.
   * 
@@ -217,8 +214,9 @@
 	 if (currProc != NULL){
 		 setTIMER(TIMER_RESET_CONST); /*Reset the timer*/
 		 currProc->p_s = *savedState; /*Saves the current process state (from the BIOS Data Page)*/
-		 currProc->p_time = currProc->p_time + get_elapsed_time(); /*Updates the CPU time used by the current process*/
-		 insertProcQ(&ReadyQueue, currProc); /* Move the current process back to the Ready Queue since it used up its time slice */
+		 chargeCpu(&(currProc->p_acct.ca_intr)); /*Updates the CPU time used by the current process*/
+		 demoteProc(currProc); /* MLFQ: it burned its whole slice -> one level down */
+		 readyProc(currProc); /* Move the current process back to the Ready Queue since it used up its time slice */
 		 currProc = NULL; /* Clear the current process pointer switch to the next process */
 		 switchProcess();  /* Call the scheduler to select and run the next process */
 	 }
@@ -236,33 +234,40 @@
   * - When an interrupt occurs, this function:  
   *   1. Reloads the Interval Timer with 100ms to reset the Pseudo-Clock
   *   2. Unblocks all processes waiting on the pseudo-clock semaphore  
-  *      (these processes were waiting via SYS7 - waitForClock()).  
-  *   3. Resets the pseudo-clock semaphore to zero
+  *      (these processes were waiting via SYS7 - waitForClockUntil()),  
+  *      detaching their queue from the ASL with removeAllBlocked() and  
+  *      splicing it onto the Ready Queue with mergeProcQ().  
+  *   3. Resets the pseudo-clock semaphore to zero, and (MLFQ) counts 
+  *      down to the next priority boost.
   *   4. Restores execution of the current process if one exists.  
   *   5. Calls the scheduler if no process is available to run.  
   * 
   * @note The pseudo-clock semaphore is used for time-based process blocking.  
-  *       Each process that calls SYS7 (waitForClock) is blocked on this semaphore until  
+  *       Each process that calls SYS7 (waitForClockUntil) is blocked on this semaphore until  
   *       the next interval timer tick, at which point it is unblocked.
   * 
   * @return None
   *****************************************************************************/
  
  void systemIntervalInterruptHandler() {
-	 pcb_PTR unblockedProc = NULL; /*pointer to a process being unblocked*/
+	 pcb_PTR unblockedQ; /*tail of the queue of processes being unblocked*/
+	 int unblockedCnt; /*number of processes being unblocked*/
 	 LDIT(INITTIMER);       /* Load the Interval Timer with 100ms to maintain periodic interrupts */
  
-	 /* Unblock all processes waiting on the pseudo-clock semaphore */
-	 while (headBlocked(&semIntTimer) != NULL){
-		 unblockedProc = removeBlocked(&semIntTimer); /* Remove a blocked process */
-		 insertProcQ(&ReadyQueue, unblockedProc); /* Move it to the Ready Queue */
-		 softBlockCnt--; /* Decrease the count of soft-blocked processes */
-	 }
+	 /* Unblock all processes waiting on the pseudo-clock semaphore: detach their whole queue
+	    from the ASL with one lookup and splice it onto the Ready Queue (O(1) under round-robin) */
+	 unblockedQ = removeAllBlocked(&semIntTimer, &unblockedCnt);
+	 readyProcQ(unblockedQ); /* Move them to the Ready Queue, in the order they blocked */
+	 softBlockCnt -= unblockedCnt; /* Decrease the count of soft-blocked processes */
+	 TRACE_EVENT(TR_WAKEALL, &semIntTimer, unblockedCnt);
+	 clockTickNote(); /* Tickless idle: they all woke, forget what they were waiting for */
+	 boostTick(); /* MLFQ: periodic priority boost */
 	 semIntTimer = 0; /* Reset the pseudo-clock semaphore to 0 */
 	 state_t *savedState = (state_t *) BIOSDATAPAGE;
  
 	 /* If there is a currently running process, resume execution */
 	 if (currProc != NULL){
+		 chargeCpu(&(currProc->p_acct.ca_intr)); /* Interrupt handling time is charged to the interrupted process */
 		 LDST(savedState);
 	 }
 	 switchProcess(); /*If no curr process to return to -> call scheduler to run next job*/
@@ -293,11 +298,13 @@
  
 	 /* Check if the interrupt came from the Process Local Timer (PLT) (Line 1) */
 	 if (((savedState->s_cause) & LINE1MASK) != ALLOFF){
+		 TRACE_EVENT(TR_INTR, TIMERINT, 0);
 		 pltInterruptHandler();  /* Call method to handle the Process Local Timer (PLT) interrupt */
 	 }
  
 	 /* Check if the interrupt came from the System-Wide Interval Timer (Line 2) */
 	 if (((savedState->s_cause) & LINE2MASK) != ALLOFF){
+		 TRACE_EVENT(TR_INTR, INTERVALTMR_LINE, 0);
 		 systemIntervalInterruptHandler(); /* Call method to the System Interval Timer interrupt */
 	 }
 	 
@@ -0,0 +1,256 @@
+/*********************************P2STRESS.C*******************************
+ *
+ *	Stress test for the Nucleus' SYS2 (process tree termination).
+ *
+ *	Builds, in turn, a deep chain of processes (each one the child of the
+ *	previous one) and a wide fan of processes (all children of one root),
+ *	with the members spread over every state a pcb can be in: blocked on
+ *	a plain semaphore, blocked on the pseudo-clock, and ready/running.
+ *	The root of each tree then kills the whole tree with one SYS2, and the
+ *	test checks that procCnt, softBlockCnt and the semaphore all come back
+ *	to their initial values, and that every pcb and semaphore descriptor
+ *	is back on its free list. Each shape takes all the procCap pcbs the
+ *	Nucleus carved at boot (test() plus one tree) and is built and killed
+ *	ROUNDS times, so a leaked pcb also makes SYS1 fail in the next round.
+ *
+ *	Produces progress messages on Terminal0.
+ *	Aborts as soon as an error is detected.
+ *
+ *	Written in the style of p2test.c by Nicolas & Tran
+ */
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initial.h"
+#include "../h/pcb.h"
+#include "../h/asl.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+typedef unsigned int devregtr;
+
+/* hardware constants */
+#define BYTELEN		8
+#define RECVD		5
+#define TERMSTATMASK	0xFF
+#define	TERM0ADDR	0x10000254
+#define QPAGE		1024
+
+/* system call codes */
+#define	CREATETHREAD	1	/* create thread */
+#define	TERMINATETHREAD	2	/* terminate thread */
+#define	PASSERN		3	/* P a semaphore */
+#define	VERHOGEN	4	/* V a semaphore */
+#define	WAITIO		5	/* delay on a io semaphore */
+#define	WAITCLOCK	7	/* delay on the clock semaphore */
+
+#define CREATENOGOOD	-1
+
+/* test shape - test() itself plus one tree fill the procCap pcbs (set in test()) */
+#define ROUNDS		10		/* times each tree is built and killed */
+#define MINSTACK	256		/* smallest stack slot a tree member can run on */
+#define MAXTICKS	20		/* pseudo-clock ticks to wait for a kill to complete */
+
+/* just to be clear */
+#define SEMAPHORE	int
+
+SEMAPHORE term_mut=1,	/* for mutual exclusion on terminal */
+		stressSem=0,	/* plain semaphore some tree members block on */
+		treeReady=0,	/* V'ed once a whole tree has been built */
+		killTree=0;	/* V'ed to make the tree root terminate itself */
+
+memaddr stackBase;		/* children stacks grow down from here */
+memaddr slotSize;		/* bytes of stack per child, QPAGE if procCap of them fit */
+int chainLen;			/* processes in the deep chain (procCap - 1) */
+int fanWidth;			/* children of the fan root (procCap - 2) */
+
+void chainNode(int depth), fanRoot(), fanLeaf(int idx), idle(int idx);
+
+
+/* a procedure to print on terminal 0 */
+void print(char *msg) {
+
+	char *s = msg;
+	devregtr * base = (devregtr *) (TERM0ADDR);
+	devregtr status;
+
+	SYSCALL(PASSERN, (int)&term_mut, 0, 0);				/* P(term_mut) */
+	while (*s != EOS) {
+		*(base + 3) = PRINTCHR | (((devregtr) *s) << BYTELEN);
+		status = SYSCALL(WAITIO, TERMINT, 0, 0);
+		if ((status & TERMSTATMASK) != RECVD)
+			PANIC();
+		s++;
+	}
+	SYSCALL(VERHOGEN, (int)&term_mut, 0, 0);				/* V(term_mut) */
+}
+
+
+/* TLB-Refill Handler */
+/* One can place debug calls here, but not calls to print */
+void uTLB_RefillHandler () {
+
+	setENTRYHI(0x80000000);
+	setENTRYLO(0x00000000);
+	TLBWR();
+
+	LDST ((state_PTR) 0x0FFFF000);
+}
+
+/* Nucleus fast path for page faults (vmSupport.c in the full kernel): no support level here */
+int tlb_fast_path(support_t *supp) {
+	return FALSE;
+}
+
+
+/* start a child of the running process executing fun(arg) on stack slot 'slot' */
+void spawn(void (*fun)(), int arg, int slot) {
+	state_t childState;
+
+	STST(&childState);
+	childState.s_sp = stackBase - (slot * slotSize);
+	childState.s_pc = childState.s_t9 = (memaddr) fun;
+	childState.s_a0 = arg;
+	childState.s_status = childState.s_status | IEPON | IMON | TEBITON;
+
+	if (SYSCALL(CREATETHREAD, (int)&childState, (int) NULL, 0) == CREATENOGOOD) {
+		print("error: SYS1 failed - pcbs leaked by an earlier SYS2\n");
+		PANIC();
+	}
+}
+
+
+/* tree members park themselves in one of the three pcb states, by index */
+void idle(int idx) {
+	switch (idx % 3) {
+	case 0:
+		SYSCALL(PASSERN, (int)&stressSem, 0, 0);	/* blocked on the ASL */
+		break;
+	case 1:
+		for (;;)
+			SYSCALL(WAITCLOCK, 0, 0, 0);	/* soft blocked on the pseudo-clock */
+	default:
+		break;
+	}
+	for (;;)
+		;						/* ready queue / running */
+}
+
+
+/* wait until the killed tree is gone and check nothing was left behind */
+void checkKilled(char *shape) {
+	int ticks = 0;
+
+	while ((procCnt != 1) && (ticks < MAXTICKS)) {
+		SYSCALL(WAITCLOCK, 0, 0, 0);
+		ticks++;
+	}
+
+	if (procCnt != 1) {
+		print("error: ");
+		print(shape);
+		print(" not fully terminated\n");
+		PANIC();
+	}
+	if (softBlockCnt != 0) {
+		print("error: softBlockCnt not restored\n");
+		PANIC();
+	}
+	if (stressSem != 0) {
+		print("error: semaphore not restored\n");
+		PANIC();
+	}
+	if (freePcbCnt() != procCap - 1) {
+		print("error: pcbs leaked\n");
+		PANIC();
+	}
+	if (freeSemdCnt() != procCap) {
+		print("error: semaphore descriptors leaked\n");
+		PANIC();
+	}
+}
+
+
+/*********************************************************************/
+/*                                                                   */
+/*                 p1 -- the root process                            */
+/*                                                                   */
+void test() {
+	int round;
+
+	/* leave test() its own page of stack; the children's go down to the end of the pools */
+	stackBase = *((int *)RAMBASEADDR) + *((int *)RAMBASESIZE) - PAGESIZE;
+	chainLen = procCap - 1;
+	fanWidth = procCap - 2;
+	slotSize = ((stackBase - kernPoolEnd) / procCap) & ~7;
+	if (slotSize > QPAGE)
+		slotSize = QPAGE;
+
+	print("p2stress starts\n");
+	if (slotSize < MINSTACK) {
+		print("error: no room for the stacks of procCap processes\n");
+		PANIC();
+	}
+
+	for (round = 0; round < ROUNDS; round++) {
+		spawn(chainNode, 1, 0);
+		SYSCALL(PASSERN, (int)&treeReady, 0, 0);		/* P(treeReady) */
+		if (procCnt != chainLen + 1) {
+			print("error: chain not fully built\n");
+			PANIC();
+		}
+		SYSCALL(VERHOGEN, (int)&killTree, 0, 0);		/* V(killTree) */
+		checkKilled("chain");
+	}
+	print("p2stress ok: deep chain killed\n");
+
+	for (round = 0; round < ROUNDS; round++) {
+		spawn(fanRoot, 0, 0);
+		SYSCALL(PASSERN, (int)&treeReady, 0, 0);		/* P(treeReady) */
+		if (procCnt != fanWidth + 2) {
+			print("error: fan not fully built\n");
+			PANIC();
+		}
+		SYSCALL(VERHOGEN, (int)&killTree, 0, 0);		/* V(killTree) */
+		checkKilled("fan");
+	}
+	print("p2stress ok: wide fan killed\n");
+
+	print("p2stress: completed\n");
+	HALT();
+}
+
+
+/* one link of the chain: spawn the next link, then park */
+void chainNode(int depth) {
+	if (depth < chainLen)
+		spawn(chainNode, depth + 1, depth);
+	else
+		SYSCALL(VERHOGEN, (int)&treeReady, 0, 0);	/* V(treeReady) */
+
+	if (depth == 1) {
+		SYSCALL(PASSERN, (int)&killTree, 0, 0);		/* P(killTree) */
+		SYSCALL(TERMINATETHREAD, 0, 0, 0);		/* kill the whole chain */
+		print("error: chain root did not terminate\n");
+		PANIC();
+	}
+	idle(depth);
+}
+
+
+/* root of the fan: spawn all the leaves, then wait to kill them */
+void fanRoot() {
+	int i;
+
+	for (i = 1; i <= fanWidth; i++)
+		spawn(fanLeaf, i, i);
+	SYSCALL(VERHOGEN, (int)&treeReady, 0, 0);		/* V(treeReady) */
+
+	SYSCALL(PASSERN, (int)&killTree, 0, 0);			/* P(killTree) */
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);			/* kill the whole fan */
+	print("error: fan root did not terminate\n");
+	PANIC();
+}
+
+
+void fanLeaf(int idx) {
+	idle(idx);
+}
@@ -0,0 +1,157 @@
+/**************************************************************************************************  
+ * @file pageCleaner.c  
+ * 
+ * This module implements the page cleaner daemon - a kernel process (ASID 0, kernel mode, like the
+ * delay daemon) that writes dirty swap pool frames back to their flash devices in the background.
+ * It keeps at least CLEANRESERVE frames free or clean, cleaning the dirty frames in the order the
+ * page replacement policy will reach them (repl_next_dirty()), so that a page fault usually only
+ * has to read the missing page instead of first writing the victim back.
+ * 
+ *      - The Pager (and the TLB-Modification handler, which turns clean frames dirty) calls
+ *        cleaner_kick() with the swap pool semaphore held; it wakes the daemon once when the
+ *        reserve runs low.
+ *      - The daemon cleans one frame at a time and does not hold the swap pool semaphore during
+ *        the write, so faults proceed while it works.
+ * 
+ * @note
+ * A frame is write-protected (D bit off in the page table and the TLB), marked clean and put in
+ * transit (busy) before it is written back with the swap pool semaphore released: the frame cannot
+ * be evicted meanwhile, and a store from its owner takes a TLB-Modification exception that marks
+ * the frame dirty again, so it is written once more later.
+ * Build with make PAGECLEANER=0 to leave all write-backs to the Pager.
+ * 
+ * @authors  
+ * Nicolas & Tran
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project  
+ **************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/initial.h"
+#include "../h/vmSupport.h"
+#include "../h/sysSupport.h"
+#include "../h/pageRepl.h"
+#include "../h/pageCleaner.h"
+#include "../h/swapSpace.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+int cleanerSema4;          /*the daemon waits here for cleaner_kick()*/
+HIDDEN int cleanerPending; /*TRUE from a kick until the daemon has refilled the reserve*/
+
+/**************************************************************************************************  
+ * @brief Counts the swap pool frames that can be reused without a write-back (free or clean).
+ * Called with the swap pool semaphore held
+ **************************************************************************************************/
+HIDDEN int count_clean(){
+    int i;
+    int count = 0;
+    for (i = 0; i < swapPoolCap; i++){
+        if (!swap_pool[i].busy && (swap_pool[i].asid == FREE || !swap_pool[i].dirty)){
+            count++;
+        }
+    }
+    return count;
+}
+
+/**************************************************************************************************  
+ * @brief Whether cleaner_kick() would wake the daemon now: the reserve of free/clean frames is
+ * below CLEANRESERVE and it is not already at work. Called with the swap pool semaphore held, or by
+ * the Nucleus fast path (which cannot kick, so it leaves such a store to the Pager)
+ **************************************************************************************************/
+int cleaner_wanted(){
+#if PAGECLEANER
+    return !cleanerPending && count_clean() < CLEANRESERVE;
+#else
+    return FALSE;
+#endif
+}
+
+/**************************************************************************************************  
+ * @brief Wakes the page cleaner daemon if the reserve of free/clean frames is below CLEANRESERVE
+ * and it is not already at work. Called with the swap pool semaphore held
+ **************************************************************************************************/
+void cleaner_kick(){
+    if (cleaner_wanted()){
+        cleanerPending = TRUE;
+        SYSCALL(SYS4,(int)&cleanerSema4,0,0);
+    }
+}
+
+/**************************************************************************************************  
+ * @brief Code of the page cleaner daemon. Sleeps until kicked, then writes back dirty frames one
+ * at a time until the reserve is refilled
+ **************************************************************************************************/
+void pageCleaner(){
+    int frame;
+    int loc;
+    unsigned int status;
+
+    while (TRUE){ /*inifinite loop*/
+        SYSCALL(SYS3,(int)&cleanerSema4,0,0); /*wait for a kick*/
+
+        while (TRUE){
+            SYSCALL(SYS3,(int)&semaphore_swapPool,0,0); /*lock swap pool*/
+            frame = (count_clean() < CLEANRESERVE) ? repl_next_dirty() : FREE;
+            if (frame == FREE){ /*reserve refilled (or nothing left to clean)*/
+                cleanerPending = FALSE;
+                SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                break;
+            }
+
+            /*Write-protect the page and mark the frame clean before the write (atomically, as the Pager does),
+              and keep it in transit (busy) so it is not evicted while the swap pool is unlocked for the write*/
+            swap_pool[frame].busy = TRUE;
+            setSTATUS(NO_INTS);
+            swap_pool[frame].dirty = FALSE;
+            swap_pool[frame].ownerEntry->entryLO &= ~D_BIT_SET;
+            update_tlb_handler(swap_pool[frame].ownerEntry);
+            setSTATUS(YES_INTS);
+            loc = swap_alloc(swap_pool[frame].asid, swap_pool[frame].pg_number); /*least busy flash device*/
+            vmStats.vm_swapDev[SWAPLOC_DEV(loc)]++;
+            SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+
+            status = flash_io(SWAPLOC_DEV(loc), SWAPLOC_BLOCK(loc), FLASHWRITE, swap_frame_addr(frame));
+
+            SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+            if (frame_reap(frame)){ /*its owner terminated during the write: the frame is free now*/
+                frame_release(frame);
+                SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                continue;
+            }
+            frame_release(frame);
+            if (status != READY){ /*leave it to the Pager (whose write-back traps the owner)*/
+                swap_pool[frame].dirty = TRUE;
+                cleanerPending = FALSE;
+                SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                break;
+            }
+            vmStats.vm_cleaned++;
+            SYSCALL(SYS4,(int)&semaphore_swapPool,0,0); /*unlock swap pool*/
+        }
+    }
+}
+
+/**************************************************************************************************  
+ * @brief Launches the page cleaner daemon via SYS1. Called by test() after initSwapStructs()
+ * 
+ * @note The daemon gets its own stack page, CLEANERSTACKPG pages below the top of RAM (inside the
+ * KERNSTACKPAGES kept free for kernel stacks), and no support structure
+ **************************************************************************************************/
+void initPageCleaner(){
+#if PAGECLEANER
+    memaddr topRAM;
+    state_t cleanerState;
+
+    cleanerSema4 = 0;
+    cleanerPending = FALSE;
+
+    RAMTOP(topRAM);
+    cleanerState.s_entryHI = (DAEMONID << SHIFT_ASID); /*kernel ASID*/
+    cleanerState.s_pc = (memaddr) pageCleaner;
+    cleanerState.s_t9 = (memaddr) pageCleaner; /*Set t9 everytime we set PC*/
+    cleanerState.s_sp = topRAM - (CLEANERSTACKPG * PAGESIZE);
+    cleanerState.s_status = ALLOFF | IEPON | IMON | TEBITON; /*kernel mode + interrupts enabled*/
+    if (SYSCALL(SYS1, (int)&cleanerState, (int)NULL, 0) != 0){
+        get_nuked(NULL); /*terminate if SYS1 fails*/
+    }
+#endif
+}
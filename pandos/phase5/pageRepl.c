@@ -0,0 +1,517 @@
+/**************************************************************************************************  
+ * @file pageRepl.c  
+ *  
+ * @brief  
+ * This module implements the swap pool page replacement policies used by the Pager (vmSupport.c).
+ * The policy is selected at build time with PAGEREPL (const.h / make PAGEREPL=...):
+ *      REPL_FIFO    - round-robin cursor over the swap pool, free frames first (the original policy)
+ *      REPL_CLOCK   - second chance: the cursor clears the reference bit of referenced pages and
+ *                     skips them once
+ *      REPL_AGING   - each sample shifts the reference bit into an aging counter, the page with the
+ *                     lowest counter is evicted
+ *      REPL_WSCLOCK - clock sweep that evicts the first page not referenced within WSTAU, or the
+ *                     least recently referenced page if every page is in the working set
+ * 
+ * @note
+ * uMPS3 has no hardware reference bit, so the V bit of the page table entry stands in for it: a
+ * resident page is "unreferenced" while its V bit is off. Touching it again raises a TLB-invalid
+ * exception that the Pager recognizes as a refault on a resident frame (the PFN still points at the
+ * frame and the swap pool entry still names the page) and resolves with repl_refault(), no flash I/O.
+ * Resident sets are accounted per ASID (repl_assign()). QUOTAMIN protects a minimum for each
+ * u-proc, QUOTAMAX caps it, and with REPLSCOPE=REPL_LOCAL a u-proc at or over its quota (a fair
+ * share of the pool) replaces its own pages, so a page-hungry u-proc cannot evict everyone else.
+ * Recently evicted clean pages are kept on a reclaim list (repl_fill_reclaim()): the page is unmapped
+ * and no longer counts as resident, but its frame keeps the contents and still names (asid, page)
+ * until it is reused, so a fault on it is resolved by repl_reclaim() without flash I/O. Frames are
+ * reused free ones first, then the oldest on the reclaim list, and only then by eviction.
+ * All functions are called with the swap pool semaphore held. Frames in transit (busy, see
+ * vmSupport.c) are never handed out, cleared or sampled.
+ * 
+ * @authors  
+ * Nicolas & Tran  
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project
+ **************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/vmSupport.h"
+#include "../h/pageRepl.h"
+#include "../h/trace.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+HIDDEN int replHand;        /*FIFO cursor / clock hand: last frame handed out*/
+HIDDEN cpu_t lastSample;    /*time of the last reference sample (Aging, WSClock)*/
+HIDDEN int residentCnt[MAXUPROCS + 1]; /*resident set size (frames held) of each asid*/
+HIDDEN int frameQuota;      /*frames a u-proc may hold before local replacement turns on*/
+HIDDEN int frameMax;        /*frames a u-proc may hold at most*/
+HIDDEN int scopeMode;       /*victim scope being tried by repl_victim() (SCOPE_*)*/
+HIDDEN int scopeAsid;       /*faulting asid for that scope*/
+HIDDEN int cleanOnly;       /*TRUE while filling the reclaim list: dirty frames are not candidates*/
+HIDDEN int reclaimCnt;      /*frames on the reclaim list*/
+HIDDEN unsigned int reclaimClock; /*last sequence number given to a frame put on the reclaim list*/
+
+/**************************************************************************************************
+ * @brief Helpers for the software reference bit (V bit of the owner's page table entry). Clearing
+ * it also rewrites the cached TLB entry, atomically as in the Pager's eviction path
+ **************************************************************************************************/
+#if PAGEREPL != REPL_FIFO
+HIDDEN int referenced(int frame){
+    return (swap_pool[frame].ownerEntry->entryLO & V_BIT_SET) != 0;
+}
+
+HIDDEN void clearReferenced(int frame){
+    setSTATUS(NO_INTS);
+    swap_pool[frame].ownerEntry->entryLO &= VALIDOFF;
+    update_tlb_handler(swap_pool[frame].ownerEntry);
+    setSTATUS(YES_INTS);
+}
+#endif
+
+/**************************************************************************************************
+ * @brief Resets the policy state and sets the frame quotas. Called by initSwapStructs() once the
+ * pool is sized and empty
+ **************************************************************************************************/
+void repl_init(){
+    int i;
+
+    replHand = 0;
+    cleanOnly = FALSE;
+    reclaimCnt = 0;
+    reclaimClock = 0;
+    STCK(lastSample);
+    for (i = 0; i <= MAXUPROCS; i++){
+        residentCnt[i] = 0;
+    }
+
+    /*Quotas: QUOTAMAX (0 = the whole pool) caps a resident set; the quota is a fair share of the pool, within [QUOTAMIN, max]*/
+    frameMax = (QUOTAMAX > 0 && QUOTAMAX < swapPoolCap) ? QUOTAMAX : swapPoolCap;
+    frameQuota = swapPoolCap / MAXUPROCS;
+    if (frameQuota < QUOTAMIN){
+        frameQuota = QUOTAMIN;
+    }
+    if (frameQuota > frameMax){
+        frameQuota = frameMax;
+    }
+}
+
+/**************************************************************************************************
+ * @brief First free frame (not in transit) after the cursor, or FREE
+ **************************************************************************************************/
+HIDDEN int free_frame(){
+    int i;
+    int frame;
+
+    for (i = 1; i <= swapPoolCap; i++){
+        frame = (replHand + i) % swapPoolCap;
+        if (swap_pool[frame].asid == FREE && !swap_pool[frame].busy){
+            replHand = frame;
+            return frame;
+        }
+    }
+    return FREE;
+}
+
+/**************************************************************************************************
+ * @brief Takes the frame that has been on the reclaim list longest off it (its page is dropped for
+ * good), or returns FREE if the list is empty
+ **************************************************************************************************/
+HIDDEN int reclaim_frame(){
+    int i;
+    int frame = FREE;
+
+    for (i = 0; i < swapPoolCap && reclaimCnt > 0; i++){
+        if (swap_pool[i].reclaimSeq != 0 && !swap_pool[i].busy &&
+            (frame == FREE || swap_pool[i].reclaimSeq < swap_pool[frame].reclaimSeq)){
+            frame = i;
+        }
+    }
+    if (frame != FREE){
+        repl_assign(frame, FREE);
+    }
+    return frame;
+}
+
+/**************************************************************************************************
+ * @brief Whether frame may be taken under the current scope (scopeMode/scopeAsid). Frames in
+ * transit never may
+ **************************************************************************************************/
+HIDDEN int candidate(int frame){
+    int owner = swap_pool[frame].asid;
+
+    /*free frames and frames on the reclaim list are handed out by repl_victim() itself*/
+    if (swap_pool[frame].busy || owner == FREE || swap_pool[frame].reclaimSeq != 0){
+        return FALSE;
+    }
+    if (cleanOnly && swap_pool[frame].dirty){
+        return FALSE;
+    }
+    switch (scopeMode){
+        case SCOPE_OWN:       /*only the faulting u-proc's own pages*/
+            return owner == scopeAsid;
+        case SCOPE_OVERQUOTA: /*pages of other u-procs holding more than their quota*/
+            return owner != scopeAsid && residentCnt[owner] > frameQuota;
+        case SCOPE_ABOVEMIN:  /*anyone's, but never take a u-proc below its minimum*/
+            return owner == scopeAsid || residentCnt[owner] > QUOTAMIN;
+        default:              /*SCOPE_ANY*/
+            return TRUE;
+    }
+}
+
+/**************************************************************************************************
+ * @brief Runs the configured policy over the frames candidate() accepts
+ *
+ * @return: index of the victim, or FREE if no frame is a candidate
+ **************************************************************************************************/
+HIDDEN int pick(){
+    int i;
+
+#if PAGEREPL == REPL_CLOCK
+    /*Second chance: clear and skip referenced pages; after one full sweep every bit is clear*/
+    for (i = 0; i < 2 * swapPoolCap; i++){
+        replHand = (replHand + 1) % swapPoolCap;
+        if (!candidate(replHand)){
+            continue;
+        }
+        if (!referenced(replHand)){
+            return replHand;
+        }
+        clearReferenced(replHand);
+    }
+    return FREE;
+#elif PAGEREPL == REPL_AGING
+    {
+        /*Lowest aging counter, ties broken in cursor order so equal pages rotate*/
+        int frame;
+        int victim = FREE;
+        for (i = 1; i <= swapPoolCap; i++){
+            frame = (replHand + i) % swapPoolCap;
+            if (!candidate(frame)){
+                continue;
+            }
+            if (victim == FREE || swap_pool[frame].age < swap_pool[victim].age){
+                victim = frame;
+            }
+        }
+        if (victim != FREE){
+            replHand = victim;
+        }
+        return victim;
+    }
+#elif PAGEREPL == REPL_WSCLOCK
+    {
+        cpu_t now;
+        int oldest = FREE;
+        STCK(now);
+        /*One sweep: referenced pages are in the working set (refresh and clear), idle ones leave it*/
+        for (i = 0; i < swapPoolCap; i++){
+            replHand = (replHand + 1) % swapPoolCap;
+            if (!candidate(replHand)){
+                continue;
+            }
+            if (referenced(replHand)){
+                swap_pool[replHand].lastUse = now;
+                clearReferenced(replHand);
+            }
+            else if (now - swap_pool[replHand].lastUse > WSTAU){
+                return replHand;
+            }
+            if (oldest == FREE || swap_pool[replHand].lastUse < swap_pool[oldest].lastUse){
+                oldest = replHand;
+            }
+        }
+        /*Every page is in the working set: take the least recently referenced one*/
+        if (oldest != FREE){
+            replHand = oldest;
+        }
+        return oldest;
+    }
+#else
+    /*FIFO: evict the next candidate after the cursor*/
+    for (i = 0; i < swapPoolCap; i++){
+        replHand = (replHand + 1) % swapPoolCap;
+        if (candidate(replHand)){
+            return replHand;
+        }
+    }
+    return FREE;
+#endif
+}
+
+/**************************************************************************************************
+ * @brief Picks the swap pool frame the Pager (re)uses for a page of asid. A free frame is always
+ * preferred (no write-back) unless asid holds its maximum quota; otherwise the victim is chosen by
+ * the configured policy, within a scope that widens until a frame is found:
+ *      - at its maximum (QUOTAMAX): its own pages
+ *      - REPL_LOCAL, at or over its quota: its own pages, then as REPL_GLOBAL
+ *      - REPL_LOCAL, under its quota: pages of u-procs over their quota, then as REPL_GLOBAL
+ *      - REPL_GLOBAL: any page, but not from a u-proc at its minimum (QUOTAMIN)
+ *      - finally any page
+ * Frames in transit are skipped; there is always another one, as each u-proc and the page cleaner
+ * have at most one frame in transit (MAXUPROCS + 1 < SWAP_POOL_CAP <= swapPoolCap)
+ *
+ * @param: asid - u-proc the frame is for
+ * @return: index of the chosen frame in the swap pool
+ **************************************************************************************************/
+int repl_victim(int asid){
+    int i;
+    int frame;
+    int scopes[4];
+    int n = 0;
+
+    /*Search the swap table starting after the cursor for a free frame, then take the oldest reclaimable one*/
+    if (residentCnt[asid] < frameMax){
+        if ((frame = free_frame()) != FREE || (frame = reclaim_frame()) != FREE){
+            return frame;
+        }
+    }
+
+    /*Scopes to try, narrowest first*/
+    if (residentCnt[asid] >= frameMax){
+        scopes[n++] = SCOPE_OWN;
+    }
+    else if (REPLSCOPE == REPL_LOCAL){
+        scopes[n++] = (residentCnt[asid] >= frameQuota) ? SCOPE_OWN : SCOPE_OVERQUOTA;
+        scopes[n++] = SCOPE_ABOVEMIN;
+    }
+    else{
+        scopes[n++] = SCOPE_ABOVEMIN;
+    }
+    scopes[n++] = SCOPE_ANY;
+
+    scopeAsid = asid;
+    for (i = 0; i < n; i++){
+        scopeMode = scopes[i];
+        frame = pick();
+        if (frame != FREE){
+            return frame;
+        }
+    }
+    /*every other frame is in transit: over the maximum rather than stall*/
+    if ((frame = free_frame()) != FREE){
+        return frame;
+    }
+    return reclaim_frame();
+}
+
+/**************************************************************************************************
+ * @brief Changes the owner of a frame in the swap pool table, keeping the per-ASID resident set
+ * counts. Every change of swap_pool[].asid goes through here; a frame on the reclaim list leaves it
+ *
+ * @param: frame - swap pool frame; asid - new owner, or FREE
+ **************************************************************************************************/
+void repl_assign(int frame, int asid){
+    if (swap_pool[frame].reclaimSeq != 0){ /*its page was already taken off the resident set*/
+        swap_pool[frame].reclaimSeq = 0;
+        reclaimCnt--;
+    }
+    else if (swap_pool[frame].asid != FREE){
+        residentCnt[swap_pool[frame].asid]--;
+    }
+    if (asid != FREE){
+        residentCnt[asid]++;
+    }
+    swap_pool[frame].asid = asid;
+}
+
+/**************************************************************************************************
+ * @brief Whether asid may take more frames without replacing its own pages (read-ahead only grows
+ * a resident set that is below its maximum and, in local mode, below its quota)
+ **************************************************************************************************/
+int repl_may_grow(int asid){
+    if (residentCnt[asid] >= frameMax){
+        return FALSE;
+    }
+    return (REPLSCOPE == REPL_GLOBAL) || (residentCnt[asid] < frameQuota);
+}
+
+/**************************************************************************************************
+ * @brief Number of swap pool frames asid holds (its resident set)
+ **************************************************************************************************/
+int repl_resident(int asid){
+    return residentCnt[asid];
+}
+
+/**************************************************************************************************
+ * @brief Keeps RECLAIMTARGET frames free or on the reclaim list, so that a page is unmapped some
+ * time before its frame is reused and a fault in between costs no flash read. Pages are taken off
+ * the resident sets in the policy's order, clean ones only (dirty ones are left to the page cleaner,
+ * which makes them clean), and never below QUOTAMIN; in local mode u-procs over their quota go first.
+ * Their page table entries keep the PFN with the V bit off, like sampled pages. Called by the Pager
+ * after each hard fault
+ **************************************************************************************************/
+void repl_fill_reclaim(){
+#if RECLAIMTARGET
+    int i;
+    int frame;
+    int spare = reclaimCnt;
+
+    for (i = 0; i < swapPoolCap; i++){
+        if (swap_pool[i].asid == FREE && !swap_pool[i].busy){
+            spare++;
+        }
+    }
+
+    cleanOnly = TRUE;
+    scopeAsid = FREE;
+    while (spare < RECLAIMTARGET){
+        frame = FREE;
+        if (REPLSCOPE == REPL_LOCAL){
+            scopeMode = SCOPE_OVERQUOTA;
+            frame = pick();
+        }
+        if (frame == FREE){
+            scopeMode = SCOPE_ABOVEMIN;
+            frame = pick();
+        }
+        if (frame == FREE){ /*every page is dirty, in transit or protected by QUOTAMIN*/
+            break;
+        }
+
+        TRACE_EVENT(TR_EVICT, swap_pool[frame].asid, swap_pool[frame].pg_number);
+        vmStats.vm_evictions++;
+        residentCnt[swap_pool[frame].asid]--;
+        swap_pool[frame].reclaimSeq = ++reclaimClock;
+        reclaimCnt++;
+        spare++;
+        setSTATUS(NO_INTS);
+        swap_pool[frame].ownerEntry->entryLO &= VALIDOFF;
+        update_tlb_handler(swap_pool[frame].ownerEntry);
+        setSTATUS(YES_INTS);
+    }
+    cleanOnly = FALSE;
+#endif
+}
+
+/**************************************************************************************************
+ * @brief Takes a frame off the reclaim list, back into its owner's resident set
+ **************************************************************************************************/
+HIDDEN void unlist(int frame){
+    swap_pool[frame].reclaimSeq = 0;
+    reclaimCnt--;
+    residentCnt[swap_pool[frame].asid]++;
+}
+
+/**************************************************************************************************
+ * @brief Soft fault on a page on the reclaim list: takes its frame off the list and maps the page
+ * again (valid and clean, referenced now)
+ **************************************************************************************************/
+void repl_reclaim(int frame){
+    unlist(frame);
+    repl_refault(frame);
+}
+
+/**************************************************************************************************
+ * @brief Like repl_victim(), but never hands out a dirty frame (read-ahead must not cost a
+ * write-back): if the policy's victim is dirty, the cursor is put back and FREE returned
+ *
+ * @param: None
+ * @return: index of a free or clean frame, or FREE
+ **************************************************************************************************/
+int repl_clean_victim(int asid){
+    int saved = replHand;
+    int frame = repl_victim(asid);
+
+    if (frame == FREE){ /*every frame is busy (being cleaned or loaded)*/
+        replHand = saved;
+        return FREE;
+    }
+    if (swap_pool[frame].asid != FREE && swap_pool[frame].dirty){
+        replHand = saved;
+        return FREE;
+    }
+    return frame;
+}
+
+/**************************************************************************************************
+ * @brief Finds the dirty frame the policy is going to reach first, for the page cleaner daemon to
+ * write back ahead of time: the lowest aging counter for Aging, otherwise the first dirty frame
+ * after the cursor (the order FIFO, Clock and WSClock sweep in)
+ *
+ * @param: None
+ * @return: index of the dirty frame, or FREE if every frame is free or clean
+ **************************************************************************************************/
+int repl_next_dirty(){
+    int i;
+    int frame;
+    int victim = FREE;
+
+    for (i = 1; i <= swapPoolCap; i++){
+        frame = (replHand + i) % swapPoolCap;
+        if (swap_pool[frame].asid != FREE && swap_pool[frame].dirty && !swap_pool[frame].busy){
+#if PAGEREPL == REPL_AGING
+            if (victim == FREE || swap_pool[frame].age < swap_pool[victim].age){
+                victim = frame;
+            }
+#else
+            return frame;
+#endif
+        }
+    }
+    return victim;
+}
+
+/**************************************************************************************************
+ * @brief Records that a page was just loaded into frame (it counts as referenced now)
+ **************************************************************************************************/
+void repl_loaded(int frame){
+    swap_pool[frame].age = AGEMSB;
+    STCK(swap_pool[frame].lastUse);
+}
+
+/**************************************************************************************************
+ * @brief Marks the page in frame valid (referenced) again and refreshes the TLB. Interrupts must
+ * be disabled
+ **************************************************************************************************/
+HIDDEN void remap(int frame){
+    swap_pool[frame].ownerEntry->entryLO |= V_BIT_SET;
+    update_tlb_handler(swap_pool[frame].ownerEntry);
+    STCK(swap_pool[frame].lastUse);
+}
+
+/**************************************************************************************************
+ * @brief Resolves a refault on a resident page whose V bit was cleared by reference sampling:
+ * marks it valid (referenced) again and refreshes the TLB
+ **************************************************************************************************/
+void repl_refault(int frame){
+    setSTATUS(NO_INTS);
+    remap(frame);
+    setSTATUS(YES_INTS);
+}
+
+/**************************************************************************************************
+ * @brief repl_refault() or repl_reclaim(), whichever applies to frame, for the Nucleus fast path
+ * (tlb_fast_path()): runs with interrupts already disabled and the swap pool semaphore free
+ **************************************************************************************************/
+void repl_remap(int frame){
+    if (swap_pool[frame].reclaimSeq != 0){
+        unlist(frame);
+    }
+    remap(frame);
+}
+
+/**************************************************************************************************
+ * @brief Periodic reference sampling, run by the Pager on every fault. At most once every
+ * REFSAMPLEPERIOD, Aging shifts each resident page's reference bit into its counter and WSClock
+ * stamps referenced pages; both then clear the bits for the next period. Clock samples in its
+ * sweep and FIFO ignores references, so for them this does nothing
+ **************************************************************************************************/
+void repl_sample(){
+#if PAGEREPL == REPL_AGING || PAGEREPL == REPL_WSCLOCK
+    int i;
+    cpu_t now;
+    STCK(now);
+    if (now - lastSample < REFSAMPLEPERIOD){
+        return;
+    }
+    lastSample = now;
+    for (i = 0; i < swapPoolCap; i++){
+        if (swap_pool[i].asid != FREE && !swap_pool[i].busy && swap_pool[i].reclaimSeq == 0){
+            swap_pool[i].age >>= 1;
+            if (referenced(i)){
+                swap_pool[i].age |= AGEMSB;
+                swap_pool[i].lastUse = now;
+                clearReferenced(i);
+            }
+        }
+    }
+#endif
+}
@@ -28,19 +28,56 @@ HIDDEN pcb_PTR pcbFree_h;
  *  Initialize the pcbFree as a non-circular linked list that contains all elements of the static array (pool) of MAXPROC pcbs
  *    --> pcbFree act as a pool of free (unused) pcbs available for allocation when a new process is created
  *  This method will be called only once during data structure initialization
+ *  @note The Nucleus sizes its pool at boot with initPcbPool() instead (see initPools() in initial.c);
+ *        this static pool is the fallback when RAM is too small for that
  *  params: None
  *  return: none 
  *****************************************************************************/
 void initPcbs() {
     static pcb_t pcb_pool[MAXPROC];         /* Pool of PCBs from which processes can be allocated */
+    initPcbPool(pcb_pool, MAXPROC);
+}
+
+/****************************************************************************  
+ *  initPcbPool
+ *  Initialize the pcbFree list to contain the count pcbs of the array pool
+ *  params: pointer to an array of pcbs, number of pcbs in the array
+ *  return: none 
+ *****************************************************************************/
+void initPcbPool(pcb_PTR pool, int count) {
     pcbFree_h = NULL;                       /* List is initially empty */
+    growPcbPool(pool, count);
+}
+
+/****************************************************************************  
+ *  growPcbPool
+ *  Add the count pcbs of the array pool to the pcbFree list
+ *  params: pointer to an array of pcbs, number of pcbs in the array
+ *  return: none 
+ *****************************************************************************/
+void growPcbPool(pcb_PTR pool, int count) {
     int i;
-    for (i = 0; i < MAXPROC; i++) {
+    for (i = 0; i < count; i++) {
         /* Add each pcb to pcbFree list */
-        freePcb(&pcb_pool[i]);
+        freePcb(&pool[i]);
     }
 }
 
+/****************************************************************************  
+ *  freePcbCnt
+ *  Count the pcbs on the pcbFree list (for the stress tests: a leak shows up here)
+ *  params: none
+ *  return: number of free pcbs
+ *****************************************************************************/
+int freePcbCnt() {
+    int count = 0;
+    pcb_PTR p;
+    for (p = pcbFree_h; p != NULL; p = p->p_next) {
+        count++;
+    }
+    return count;
+}
+
 /**************************************************************************** 
  *  freePcb
  *  Insert the pcb pointed to by pointer p to the pcbFree list. 
@@ -98,7 +135,14 @@ pcb_PTR allocPcb() {
         freed_pcb_ptr->p_s.s_reg[i] = 0;
     }
     freed_pcb_ptr->p_time = 0;
+    freed_pcb_ptr->p_acct.ca_user = 0;
+    freed_pcb_ptr->p_acct.ca_sys = 0;
+    freed_pcb_ptr->p_acct.ca_intr = 0;
+    freed_pcb_ptr->p_acct.ca_support = 0;
     freed_pcb_ptr->p_semAdd = NULL;
+    freed_pcb_ptr->p_semd = NULL;
+    freed_pcb_ptr->p_prio = 0;
+    freed_pcb_ptr->p_boost = 0;
 
     /* Support layer info */
     freed_pcb_ptr->p_supportStruct = NULL;
@@ -190,37 +234,60 @@ pcb_PTR removeProcQ (pcb_PTR *tp){
  *  outProcQ
  *  Remove the pcb pointed to by p from the process queue whose tailpointer 
  *  is pointed to by tp. Update the process queue’s tail pointer if necessary.
+ *  Since the queue is doubly linked, p is unlinked in O(1) through its own 
+ *  p_prev/p_next pointers instead of walking the queue to find it.
+ * 
+ *  @note The caller must know that p is either on this queue or on no queue 
+ *        at all (p_next == NULL). The ASL knows it from p->p_semd, the Nucleus 
+ *        knows it for the Ready Queue from the pcb not being blocked/running.
  *  params: pointer to tail pointer of process queue, pcb pointer
- *  return: pointer to pcb p after it's removed from the queue. If not found, return NULL
+ *  return: pointer to pcb p after it's removed from the queue. If p is on no queue, return NULL
  *****************************************************************************/
 pcb_PTR outProcQ (pcb_PTR *tp, pcb_PTR p){
-    if (emptyProcQ(*tp)) return NULL;
+    if (emptyProcQ(*tp) || p->p_next == NULL) return NULL;
 
-    pcb_PTR curr = (*tp)->p_next;           /*start at head*/
-    pcb_PTR prev = *tp;                     /*trailing pointer starting from tail*/
+    /*if p is the tail, the tail moves back to p's predecessor (or the queue becomes empty)*/
+    if (p == *tp){
+        if (p->p_next == p) {*tp = NULL;}    /*if only one node in process queue*/
+        else {*tp = p->p_prev;}             /*update tail to previous pcb node*/
+    }
 
+    /*Disconnect node from queue*/
+    p->p_prev->p_next = p->p_next;
+    p->p_next->p_prev = p->p_prev;
 
-    /*Loop through the list with curr,prev pointers until we find p, or until we circle back to the head (complete one loop)*/
-    do {
-        if (curr == p){
-            /*Disconnect node from queue*/
-            prev->p_next = curr->p_next;
-            curr->p_next->p_prev = prev;
+    p->p_next = NULL;
+    p->p_prev = NULL;
+    return p;
+}
 
-            /*if curr is the tail*/
-            if (curr == *tp){
-                if (curr == prev) {*tp = NULL;}     /*if only one node in process queue*/
-                else {*tp = prev;}                  /*update tail to previous pcb node*/
-            }
 
-            curr->p_next = NULL;
-            curr->p_prev = NULL;
-            return curr;
-        }
-        prev = curr;
-        curr = curr->p_next;
-    } while (curr != (*tp)->p_next);
-    return NULL;
+/**************************************************************************** 
+ *  mergeProcQ
+ *  Append the whole process queue whose tail is src to the end of the process 
+ *  queue whose tail pointer is pointed to by tp, keeping the order of both. 
+ *  Since both queues are circular, only the two head/tail junctions are 
+ *  relinked: O(1) whatever the length of either queue.
+ *  params: pointer to tail pointer of the destination queue, tail of the queue to append
+ *  return: none. src's pcbs now belong to the queue at *tp (src must not be used again)
+ *****************************************************************************/
+void mergeProcQ (pcb_PTR *tp, pcb_PTR src){
+    if (emptyProcQ(src)) return;
+
+    /*Destination empty --> src simply becomes the queue*/
+    if (emptyProcQ(*tp)){
+        *tp = src;
+        return;
+    }
+
+    pcb_PTR destHead = (*tp)->p_next;       /*current head of the destination queue*/
+    pcb_PTR srcHead = src->p_next;          /*head of the queue being appended*/
+
+    (*tp)->p_next = srcHead;                /*old tail -> first pcb of src*/
+    srcHead->p_prev = *tp;
+    src->p_next = destHead;                 /*src's tail closes the circle*/
+    destHead->p_prev = src;
+    *tp = src;                              /*src's tail is the new tail*/
 }
 
 
@@ -6,12 +6,18 @@
  * 
  * @brief
  * This module implements the process scheduling mechanism and deadlock detection to ensure 
- * system progress and prevent indefinite waiting. It employs a preemptive round-robin 
+ * system progress and prevent indefinite waiting. By default it employs a preemptive round-robin 
  * scheduling algorithm with a fixed time slice of 5ms to ensure fair CPU allocation among processes.
+ * Built with SCHEDPOLICY == SCHED_MLFQ (make SCHED=SCHED_MLFQ), it is a multi-level feedback 
+ * queue instead: MLFQLEVELS ready queues, level l running with a (TIMESLICE << l) quantum.
+ * A process that burns its whole slice moves one level down, one that waits for I/O (SYS5) 
+ * one level up, and every MLFQBOOSTTICKS pseudo-clock ticks all processes go back to level 0.
  * 
  * 
  * @details
  * The scheduler is responsible for:
+ * - Owning the Ready Queue(s): the rest of the Nucleus makes processes ready through 
+ *   readyProc()/readyProcQ() and takes them back out through unreadyProc().
  * - Selecting the next process from the Ready Queue and assigning it as the current process.
  * - Managing CPU time allocation through a process-local timer (PLT) to enforce time slices.
  * - Handling scenarios when no ready processes exist:
@@ -35,10 +41,17 @@
 #include "../h/initial.h"
 #include "../h/exceptions.h"
 #include "../h/interrupts.h"
+#include "../h/trace.h"
 
 #include "/usr/include/umps3/umps/libumps.h"
 
 volatile cpu_t quantum;
+HIDDEN pcb_PTR readyQueues[READYLEVELS]; /*Tail pointers to the queues of pcbs in the “ready” state, one per level (highest first)*/
+HIDDEN unsigned int boostEpoch; /*MLFQ: number of priority boosts so far*/
+HIDDEN int boostTicks; /*MLFQ: pseudo-clock ticks since the last priority boost*/
+HIDDEN int clockPlainWaiters; /*SYS7 waiters since the last tick that need the very next tick*/
+HIDDEN cpu_t clockDeadline; /*earliest TOD some pseudo-clock waiter really needs to run at (LARGETIME if none)*/
+HIDDEN int clockTickless; /*TRUE while the interval timer is programmed past the regular 100ms tick*/
 
 /***********************HELPER METHODS***************************************/
 
@@ -80,6 +93,199 @@ void copyState(state_PTR src, state_PTR dst){
 
 }
 
+/****************************************************************************
+ * procLevel()
+ * 
+ * @brief 
+ * Returns the ready queue level of p (always 0 under round-robin).
+ * 
+ * @note
+ * A boost resets every process to level 0 without touching the pcbs: a 
+ * level recorded before the last boost (p_boost != boostEpoch) is stale 
+ * and read as 0, so the boost is O(MLFQLEVELS) rather than O(processes).
+ * 
+ * @param p - pointer to a pcb
+ * @return level of p, 0 being the highest
+ *****************************************************************************/
+HIDDEN int procLevel(pcb_PTR p){
+    if (READYLEVELS == 1){
+        return 0;
+    }
+    if (p->p_boost != boostEpoch){
+        p->p_prio = 0;
+        p->p_boost = boostEpoch;
+    }
+    return p->p_prio;
+}
+
+/*Initialize the (empty) ready queues*/
+void initReadyQueues(){
+    int i;
+    for (i = 0; i < READYLEVELS; i++){
+        readyQueues[i] = mkEmptyProcQ();
+    }
+    boostEpoch = 0;
+    boostTicks = 0;
+    clockPlainWaiters = 0;
+    clockDeadline = LARGETIME;
+    clockTickless = FALSE;
+}
+
+/*Make p ready: insert it at the tail of the ready queue of its level*/
+void readyProc(pcb_PTR p){
+    insertProcQ(&readyQueues[procLevel(p)], p);
+}
+
+/*Make a whole process queue (tail pointer tp) ready, keeping its order. Under round-robin the 
+  queue is spliced on in O(1); under MLFQ its pcbs may belong to different levels, so they are 
+  dealt out one by one*/
+void readyProcQ(pcb_PTR tp){
+    pcb_PTR p;
+    if (READYLEVELS == 1){
+        mergeProcQ(&readyQueues[0], tp);
+        return;
+    }
+    while ((p = removeProcQ(&tp)) != NULL){
+        readyProc(p);
+    }
+}
+
+/*Take the ready (neither running nor blocked) process p off its ready queue*/
+pcb_PTR unreadyProc(pcb_PTR p){
+    return outProcQ(&readyQueues[procLevel(p)], p);
+}
+
+/*MLFQ: p used up its whole quantum -> move it one level down*/
+void demoteProc(pcb_PTR p){
+    int level = procLevel(p);
+    if (level < READYLEVELS - 1){
+        p->p_prio = level + 1;
+    }
+}
+
+/*MLFQ: p gave up the CPU to wait for I/O -> move it one level up*/
+void promoteProc(pcb_PTR p){
+    int level = procLevel(p);
+    if (level > 0){
+        p->p_prio = level - 1;
+    }
+}
+
+/****************************************************************************
+ * boostTick()
+ * 
+ * @brief 
+ * Called on every pseudo-clock tick (100ms). Under MLFQ, every MLFQBOOSTTICKS 
+ * ticks all processes go back to level 0, so that CPU-bound processes sunk to 
+ * the lowest level cannot be starved by a stream of interactive ones.
+ * The lower ready queues are spliced, in order, behind level 0 and the boost 
+ * epoch is advanced, which makes every recorded level stale (see procLevel()).
+ * 
+ * @param None
+ * @return None
+ *****************************************************************************/
+void boostTick(){
+    int i;
+    if (READYLEVELS == 1){
+        return;
+    }
+    boostTicks++;
+    if (boostTicks < MLFQBOOSTTICKS){
+        return;
+    }
+    boostTicks = 0;
+    boostEpoch++;
+    for (i = 1; i < READYLEVELS; i++){
+        mergeProcQ(&readyQueues[0], readyQueues[i]);
+        readyQueues[i] = mkEmptyProcQ();
+    }
+}
+
+/****************************************************************************
+ * clockWaitNote() / clockTickNote() / requestClockBy()
+ * 
+ * @brief 
+ * Bookkeeping of what the pseudo-clock waiters really need, for tickless idle.
+ * 
+ * @details
+ * - SYS7 with a1 == CLOCKNEXTTICK (every plain SYS7) needs the next 100ms tick.
+ * - SYS7 with any other a1 only needs to run again by TOD a1 (LARGETIME: not 
+ *   before some other event); the delay daemon waits this way on the head of the ADL.
+ * - requestClockBy() lets the support level bring the deadline forward without 
+ *   waiting (SYS18 inserting a new sleeper while the daemon is already blocked).
+ * - On each tick every SYS7 waiter is woken: plain waiters are forgotten, and 
+ *   deadlines that have passed are dropped (their waiter runs now). Deadlines still 
+ *   in the future are kept, so a requestClockBy() racing with the daemon's SYS7 
+ *   is never lost; at worst it costs one early wake-up.
+ * 
+ * @param deadline - TOD (microseconds, as STCK) the waiter needs to run by
+ * @return None
+ *****************************************************************************/
+void clockWaitNote(cpu_t deadline){
+    if (deadline == CLOCKNEXTTICK){
+        clockPlainWaiters++;
+    }
+    else if (deadline < clockDeadline){
+        clockDeadline = deadline;
+    }
+}
+
+void clockTickNote(){
+    cpu_t now;
+    STCK(now);
+    clockPlainWaiters = 0;
+    clockTickless = FALSE;
+    if (clockDeadline <= now){
+        clockDeadline = LARGETIME;
+    }
+}
+
+void requestClockBy(cpu_t deadline){
+    unsigned int status = getSTATUS();
+    setSTATUS(status & (~IECON)); /*the tick handler also updates clockDeadline*/
+    if (deadline < clockDeadline){
+        clockDeadline = deadline;
+    }
+    setSTATUS(status);
+}
+
+/****************************************************************************
+ * programIdleClock()
+ * 
+ * @brief 
+ * Tickless idle: called right before WAIT. Unless some SYS7 waiter needs the 
+ * next regular tick, reprogram the interval timer for the earliest pseudo-clock 
+ * deadline, or as far out as it goes (i.e. off) when there is none.
+ * The regular 100ms tick is restored by the next dispatch (switchProcess) or 
+ * by the tick itself, whichever comes first.
+ * 
+ * @param None
+ * @return None
+ *****************************************************************************/
+HIDDEN void programIdleClock(){
+    cpu_t timescale = *((cpu_t *) TIMESCALEADDR);
+    cpu_t maxIdle = TIMER_RESET_CONST / timescale; /*longest interval LDIT can load*/
+    cpu_t tickLeft = *((cpu_t *) INTERVALTMR) / timescale; /*time left to the regular tick*/
+    cpu_t now;
+    cpu_t idle;
+
+    if (!TICKLESS || (clockPlainWaiters > 0)){
+        return;
+    }
+    idle = maxIdle;
+    if (clockDeadline != LARGETIME){
+        STCK(now);
+        idle = (clockDeadline > now) ? (clockDeadline - now) : 1;
+        if (idle > maxIdle){
+            idle = maxIdle;
+        }
+    }
+    if (idle > tickLeft){
+        LDIT(idle);
+        clockTickless = TRUE;
+    }
+}
+
 /***************************SCHEDULER*************************************/
 
 /**************************************************************************** 
@@ -101,7 +307,8 @@ void copyState(state_PTR src, state_PTR dst){
  * 
  * @protocol
  * 1.Check ReadyQueue:
- *    - If a process is available, remove it from the queue and set it as currProc.
+ *    - If a process is available, remove it from the queue (the highest non-empty level 
+ *      under MLFQ) and set it as currProc.
  *    - If no processes are ready:
  *      - If no processes exist, halt the system
  *      - If there are processes blocked on I/O, enter a wait state
@@ -110,10 +317,12 @@ void copyState(state_PTR src, state_PTR dst){
  * 2. Schedule Next Process:
  *    - Set currProc to the next process in the ReadyQueue.
  *    - Start its execution by restoring its processor state.
- *    - Set the Process Local Timer (PLT) to enforce time-sharing (5ms time slice).
+ *    - Set the Process Local Timer (PLT) to enforce time-sharing (5ms time slice, 
+ *      TIMESLICE << level under MLFQ).
  *
  * 3. Handle Empty ReadyQueue:
- *    - If no ready processes exist but some are waiting on I/O, enter a wait state.
+ *    - If no ready processes exist but some are waiting on I/O, enter a wait state 
+ *      (tickless: with the interval timer set for the next real deadline, see programIdleClock()).
  *    - If no processes are running or waiting for I/O, a deadlock has occurred, and the system panics.
  *
  * @note 
@@ -125,17 +334,29 @@ void copyState(state_PTR src, state_PTR dst){
  *****************************************************************************/
 
 void switchProcess() {
-	currProc = removeProcQ(&ReadyQueue); /* Remove a process from the ReadyQueue and assign it as the current process */
+	int level = 0; /*ready queue level the next process is taken from*/
+
+    /* Remove a process from the highest non-empty ReadyQueue and assign it as the current process */
+    while ((level < READYLEVELS - 1) && emptyProcQ(readyQueues[level])){
+        level++;
+    }
+	currProc = removeProcQ(&readyQueues[level]);
+    TRACE_EVENT(TR_SWITCH, currProc, level);
 
     /* If the ReadyQueue is not empty, schedule the next process */
     if (currProc != NULL){
-        setTIMER(TIMESLICE);     /* Set Process Local Timer (PLT) to 5ms for time-sharing */
+        if (clockTickless){
+            LDIT(INITTIMER); /*back from a tickless idle -> restore the regular 100ms tick*/
+            clockTickless = FALSE;
+        }
+        setTIMER(TIMESLICE << level);     /* Set Process Local Timer (PLT) to 5ms (longer on lower MLFQ levels) for time-sharing */
         STCK(quantum); /*record current quantum*/
 		LDST(&(currProc->p_s)); /*perform context switch to load state of the new process -> effectively handing control over to new proc*/
     }
 
     /* If there are no active processes left in the system, halt execution */
     if (procCnt == INITPROCCNT){
+        traceDump(); /* Leave the trace ring on the trace printer (TRACE builds) */
         HALT(); /* No more processes to execute, system stops */
     }
 
@@ -143,6 +364,7 @@ void switchProcess() {
     if ((procCnt > 0) && (softBlockCnt > 0)){
 		unsigned int curr_status = getSTATUS(); /*get current status*/
 		setTIMER(TIMER_RESET_CONST); /*set timer to max possible value of unsigned 32 bit int to prevent premature timer interrupt*/
+		programIdleClock(); /*tickless: skip the 100ms ticks nobody is waiting for*/
         setSTATUS((curr_status) | IMON | IECON); /* Enable interrupts before waiting */
 		WAIT(); /*issue wait*/
         setSTATUS(curr_status); /*restore original processor state after WAIT() period*/
@@ -150,6 +372,7 @@ void switchProcess() {
 
     /* If the system reaches this point, it means no processes are ready or waiting on I/O */
     /* This indicates a deadlock situation, meaning all processes are blocked with no recovery */
+    traceDump(); /* Leave the trace ring on the trace printer (TRACE builds) */
     PANIC();  /* Trigger a system panic as no forward progress can be made */
 }
 
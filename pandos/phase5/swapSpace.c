@@ -0,0 +1,140 @@
+/**************************************************************************************************
+ * @file swapSpace.c
+ *
+ * @brief
+ * This module implements the swap space layer of the Pager: where each page of each u-proc lives
+ * on flash while it is not resident. A page starts out in its program's own flash image (device
+ * asid - 1, block = page number, the "home" location). With STRIPESWAP on, the top SWAPSLOTS blocks
+ * of every installed flash device form a shared swap area, and a page written back is given a slot
+ * on the least busy device (shortest queue on its device semaphore, ties taken round-robin), so the
+ * write-backs of a thrashing u-proc are spread over all flash units instead of queueing on its own.
+ *
+ * Locations are encoded SWAPLOC(device, block). The Pager calls swap_locate() before reading a
+ * page and swap_alloc() before writing one back, both with the swap pool semaphore held; the I/O
+ * itself is done with flash_io() after releasing it.
+ *
+ * @note
+ * Blocks in a swap area are no longer available to SYS16/SYS17 (swap_user_blocks()). A device too
+ * small to hold its program image (PAGE_TABLE_MAX + 1 blocks) and a swap area gets none.
+ * Build with make STRIPESWAP=0 to write every page back to its home location.
+ *
+ * @authors
+ * Nicolas & Tran
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project
+ **************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/sysSupport.h"
+#include "../h/vmSupport.h"
+#include "../h/swapSpace.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+HIDDEN unsigned int areaStart[DEV_UNITS];      /*first block of each flash device's swap area (its block count if it has none)*/
+HIDDEN int slotCap[DEV_UNITS];                 /*swap slots of each device: SWAPSLOTS or 0*/
+HIDDEN int slotCnt[DEV_UNITS];                 /*swap slots in use on each device*/
+HIDDEN int slotUsed[DEV_UNITS][SWAPSLOTS];     /*TRUE for a slot holding a page*/
+HIDDEN int pageLoc[MAXUPROCS + 1][PAGE_TABLE_MAX + 1]; /*swap slot of each page, FREE while it is at home*/
+HIDDEN int stripeHand;                         /*device the last slot was taken from*/
+
+/**************************************************************************************************
+ * @brief Sets up the swap areas of the installed flash devices and puts every page at home.
+ * Called by initSwapStructs()
+ **************************************************************************************************/
+void swap_init(){
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    unsigned int maxBlock;
+    int dev;
+    int i;
+
+    for (dev = 0; dev < DEV_UNITS; dev++){
+        maxBlock = busRegArea->devreg[((FLASHINT - DISKINT) * DEVPERINT) + dev].d_data1;
+        areaStart[dev] = maxBlock;
+        slotCap[dev] = 0;
+        slotCnt[dev] = 0;
+        if (STRIPESWAP && (busRegArea->inst_dev[FLASHINT - DISKINT] & (1 << dev))
+            && maxBlock >= (PAGE_TABLE_MAX + 1) + SWAPSLOTS){
+            areaStart[dev] = maxBlock - SWAPSLOTS;
+            slotCap[dev] = SWAPSLOTS;
+        }
+        for (i = 0; i < SWAPSLOTS; i++){
+            slotUsed[dev][i] = FALSE;
+        }
+    }
+    for (i = 0; i <= MAXUPROCS; i++){
+        for (dev = 0; dev <= PAGE_TABLE_MAX; dev++){
+            pageLoc[i][dev] = FREE;
+        }
+    }
+    stripeHand = 0;
+}
+
+/**************************************************************************************************
+ * @brief Flash location holding the current copy of a non-resident page
+ *
+ * @param: asid, page_no - the page (0-31)
+ * @return: SWAPLOC(device, block)
+ **************************************************************************************************/
+int swap_locate(int asid, int page_no){
+    if (pageLoc[asid][page_no] != FREE){
+        return pageLoc[asid][page_no];
+    }
+    return SWAPLOC(asid - 1, page_no);
+}
+
+/**************************************************************************************************
+ * @brief Gives back the swap slot of a page (it is at home again)
+ **************************************************************************************************/
+void swap_free_page(int asid, int page_no){
+    int loc = pageLoc[asid][page_no];
+    int dev;
+
+    if (loc != FREE){
+        dev = SWAPLOC_DEV(loc);
+        slotUsed[dev][SWAPLOC_BLOCK(loc) - areaStart[dev]] = FALSE;
+        slotCnt[dev]--;
+        pageLoc[asid][page_no] = FREE;
+    }
+}
+
+/**************************************************************************************************
+ * @brief Picks where a dirty page is written back: a free slot on the device with the shortest
+ * queue (the highest device semaphore value), rotating among equally busy devices, or its home
+ * block if no device has a free slot. The page's previous slot is released first, its copy there
+ * is stale
+ *
+ * @param: asid, page_no - the page being written back
+ * @return: SWAPLOC(device, block) to write it to
+ **************************************************************************************************/
+int swap_alloc(int asid, int page_no){
+    int i;
+    int dev;
+    int best = FREE;
+
+    swap_free_page(asid, page_no);
+    for (i = 1; i <= DEV_UNITS; i++){
+        dev = (stripeHand + i) % DEV_UNITS;
+        if (slotCnt[dev] < slotCap[dev] &&
+            (best == FREE || devSema4_support[DEV_UNITS + dev] > devSema4_support[DEV_UNITS + best])){
+            best = dev;
+        }
+    }
+    if (best == FREE){
+        return SWAPLOC(asid - 1, page_no);
+    }
+
+    stripeHand = best;
+    for (i = 0; slotUsed[best][i]; i++){
+        ; /*slotCnt < slotCap: there is a free one*/
+    }
+    slotUsed[best][i] = TRUE;
+    slotCnt[best]++;
+    pageLoc[asid][page_no] = SWAPLOC(best, areaStart[best] + i);
+    return pageLoc[asid][page_no];
+}
+
+/**************************************************************************************************
+ * @brief Number of blocks of a flash device SYS16/SYS17 may use (those below its swap area)
+ **************************************************************************************************/
+unsigned int swap_user_blocks(int flashNo){
+    return areaStart[flashNo];
+}
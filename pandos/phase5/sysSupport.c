@@ -26,21 +26,25 @@
 #include "../h/sysSupport.h"
 #include "../h/deviceSupportDMA.h"
 #include "../h/delayDaemon.h"
+#include "../h/diskCache.h"
+#include "../h/trace.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /*Support level device semaphores*/
 int devSema4_support[DEVICE_TYPES * DEV_UNITS]; 
+int devHolder[DEVICE_TYPES * DEV_UNITS]; /*asid of the u-proc holding each one during its SYS, FREE otherwise*/
 
 
 /************************************************************************************************** 
  * @brief get_nuked() (or SYS9) is a essentially a wrapper for the kernel-mode restricted SYS2 service
  * 
  * @details
- * 1. Calculate the device index based on the uproc's proccess_id (ASID)
- * 2. Release all device semaphores the uproc is holding
- * 3. Invalidate all frames in the page table of the current uproc
- * 4. Decrement the master semaphore & de-allocate support_struct of U's proc (return back to free pool of suppStructs)
- * 5. Make SYSCALL 2 to terminate uproc and its children processes
+ * 1. Release the device semaphores the uproc is holding (devHolder). The disk and flash
+ *    semaphores are shared by every u-proc, the Pagers and the daemons, so a semaphore at 0 is
+ *    not necessarily the dying uproc's: only those it recorded itself are released
+ * 2. Invalidate all frames in the page table of the current uproc
+ * 3. Decrement the master semaphore & de-allocate support_struct of U's proc (return back to free pool of suppStructs)
+ * 4. Make SYSCALL 2 to terminate uproc and its children processes
  * 
  * @param: support_struct - pointer to the support structure of the current uproc. This makes it easier to access
  *                          fields like asid and the private page table
@@ -52,14 +56,12 @@ int devSema4_support[DEVICE_TYPES * DEV_UNITS];
  **************************************************************************************************/
 void get_nuked(support_t *support_struct)
 {
-    int dev_num = support_struct->sup_asid - 1;
-
     /*If the process is currently holding mutex of devices -> release all those locks*/
     int i;
-    for (i = 0; i < DEVICE_TYPES; i++) {
-        int index = i * DEV_UNITS + dev_num;
-        if (devSema4_support[index] == 0){
-            SYSCALL(SYS4, (memaddr)&devSema4_support[index],0,0);
+    for (i = 0; i < DEVICE_TYPES * DEV_UNITS; i++) {
+        if (devHolder[i] == support_struct->sup_asid){
+            devHolder[i] = FREE;
+            SYSCALL(SYS4, (memaddr)&devSema4_support[i],0,0);
         }
     }
 
@@ -72,6 +74,7 @@ void get_nuked(support_t *support_struct)
             setSTATUS(YES_INTS);
         }
     }
+    swap_release_asid(support_struct->sup_asid); /*its frames go back to the swap pool (and its resident set to 0)*/
     SYSCALL(SYS4, (memaddr) &masterSema4, 0, 0);
     deallocate(support_struct); /*de-allocate the support structure*/
     SYSCALL(SYS2, 0, 0, 0); /*Make the call to sys2 to terminate the uproc and its child processes*/
@@ -98,6 +101,36 @@ void getTOD(state_PTR excState)
 }
 
 
+/**************************************************************************************************
+ * @brief The method implements SYS21 (GETCPUSTATS) - report the calling uproc's CPU time, split 
+ * by where it was spent
+ * 
+ * @details
+ * 1. Check that the cpuacct_t to be filled lies in the uproc logical address space
+ * 2. Ask the Nucleus for the split (SYS6 with a1 = kernel buffer)
+ * 3. Copy it to the uproc's cpuacct_t and return the total CPU time in v0
+ * 
+ * @note The buckets (user / Nucleus SYSCALL / interrupt / support level, see cpuacct_t) add up to 
+ *       the total, which is what SYS6 reports to kernel-mode processes.
+ * 
+ * @param:
+ *      1. virtualAddr - address of the uproc's cpuacct_t
+ *      2. support_struct - pointer to support struct of current uproc
+ * 
+ * @return: None
+ **************************************************************************************************/
+void get_cpu_stats(cpuacct_t *virtualAddr, support_t *support_struct){
+    cpuacct_t acct; /*kernel copy of the split*/
+    cpu_t totalTime;
+
+    if ((unsigned int) virtualAddr < KUSEG){ /*must not write outside the uproc address space*/
+        get_nuked(support_struct);
+    }
+    totalTime = SYSCALL(SYS6, (int) &acct, 0, 0);
+    *virtualAddr = acct;
+    support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = totalTime;
+}
+
 /**************************************************************************************************
  * @brief The method performs a WRITE operation to a specific printer device
  * 
@@ -153,6 +186,7 @@ void write_to_printer(char *virtualAddr, int len, support_t *support_struct) {
     char_printed_count = 0;
 
     SYSCALL(SYS3, (memaddr)&devSema4_support[semIndex], 0, 0); /*Lock the printer device*/
+    devHolder[semIndex] = support_struct->sup_asid;
 
     devregarea_t *busRegArea = (devregarea_t *)RAMBASEADDR; /* Pointer to the bus register area */
     device_t *printerDev = &(busRegArea->devreg[semIndex]); /*Pointer to printer device register*/
@@ -173,6 +207,7 @@ void write_to_printer(char *virtualAddr, int len, support_t *support_struct) {
         }
     }
     support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = char_printed_count; /*return transmitted character count in v0 if successful print*/
+    devHolder[semIndex] = FREE;
     SYSCALL(SYS4, (memaddr) &devSema4_support[semIndex], 0, 0); /*unlock printer device*/
 }
 
@@ -232,6 +267,7 @@ void write_to_terminal(char *virtualAddr, int len, support_t *support_struct) {
     device_t *terminalDevice = (device_t *)(DEVICEREGSTART + totalOffset);
 
     SYSCALL(SYS3,(memaddr) &devSema4_support[semIndex], 0, 0); /*Lock terminal device*/
+    devHolder[semIndex] = support_struct->sup_asid;
 
     /*Iterate through each character in the string*/
     int i;
@@ -250,6 +286,7 @@ void write_to_terminal(char *virtualAddr, int len, support_t *support_struct) {
         }
     }
     support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = transmittedChars; /*return transmitted character count in v0 if successful print*/
+    devHolder[semIndex] = FREE;
     SYSCALL(SYS4,(memaddr) &devSema4_support[semIndex], 0, 0); /*unlock terminal device*/
 }
 
@@ -310,6 +347,7 @@ void read_from_terminal(char *virtualAddr, support_t *support_struct){
     device_t *terminalDevice = (device_t *)(DEVICEREGSTART + totalOffset);
 
     SYSCALL(SYS3,(memaddr) &devSema4_support[semIndex], 0, 0);
+    devHolder[semIndex] = support_struct->sup_asid;
 
     char currChar = ' '; /*build the char being read in*/
     int receivedChars; /*tracks how many characters were read in*/
@@ -347,6 +385,7 @@ void read_from_terminal(char *virtualAddr, support_t *support_struct){
     else{
         support_struct->sup_exceptState[GENERALEXCEPT].s_v0 = receivedChars; /*return received character count in v0 if successful*/
     }
+    devHolder[semIndex] = FREE;
     SYSCALL(SYS4,(memaddr) &devSema4_support[semIndex], 0, 0); /*unlock terminal semaphore*/
 }
 
@@ -399,12 +438,14 @@ void syscall_excp_handler(support_t *currProc_support_struct,int syscall_num_req
     /*----------------------------------------------------------*/
 
     /* Validate syscall number */
-    if (syscall_num_requested < SYS9 || syscall_num_requested > 18) { /*Will have to change for future phases*/
+    if (syscall_num_requested < SYS9 || syscall_num_requested > SYS22) { /*Will have to change for future phases*/
         /* Invalid syscall number, treat as Program Trap */
         syslvl_prgmTrap_handler(currProc_support_struct);
         return;
     }
 
+    TRACE_EVENT(TR_SUPSYS, syscall_num_requested, currProc_support_struct->sup_asid);
+
     /*Step 2: Read values in registers a1-a3*/
     a1_val = currProc_support_struct->sup_exceptState[GENERALEXCEPT].s_a1;
     a2_val = currProc_support_struct->sup_exceptState[GENERALEXCEPT].s_a2;
@@ -454,10 +495,19 @@ void syscall_excp_handler(support_t *currProc_support_struct,int syscall_num_req
             sys18Handler(a1_val,currProc_support_struct);
             break;
 
+        case SYS21:
+            get_cpu_stats((cpuacct_t *) a1_val, currProc_support_struct);
+            break;
+
+        case SYS22:
+            disk_sync(currProc_support_struct);
+            break;
+
         default:
             syslvl_prgmTrap_handler(currProc_support_struct);
             break;
     }
+    TRACE_EVENT(TR_SUPRET, syscall_num_requested, currProc_support_struct->sup_asid);
     LDST(&(currProc_support_struct->sup_exceptState[GENERALEXCEPT]));
 }
 
@@ -0,0 +1,126 @@
+/************************************************************************************************ 
+ * CS372 - Dr. Goldweber
+ * 
+ * @file trace.c
+ * 
+ * 
+ * @brief
+ * This module implements a kernel trace ring: a fixed-size buffer of TRACESIZE binary 
+ * records (tracerec_t) kept in kernel memory, each stamped with the TOD clock (STCK). 
+ * Once the ring is full the oldest records are overwritten.
+ * 
+ * 
+ * @details
+ * - Tracepoints (TRACE_EVENT() in trace.h) sit on context switches, Nucleus and support 
+ *   level syscall entry/exit, interrupts, page faults/evictions and semaphore block/unblock.
+ * - With TRACE == 0 (the default) every tracepoint compiles to nothing and the ring is 
+ *   not allocated; build with make TRACE=1 to turn tracing on.
+ * - traceDump() writes the ring to printer TRACEPRINTER (print7.umps on the host), one 
+ *   record per line, in hex:
+ *       T <records> <overwritten>
+ *       <tod> <type> <a> <b>
+ *   It polls the printer with interrupts off, so it is only called where the system 
+ *   stops anyway: HALT and PANIC in the scheduler.
+ * 
+ * 
+ * @authors Nicolas & Tran
+ * View version history and changes: https://github.com/AtypicalAsian/CS372-OS-Project
+ ************************************************************************************************/
+#include "../h/types.h"
+#include "../h/const.h"
+#include "../h/trace.h"
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#if TRACE
+HIDDEN tracerec_t traceRing[TRACESIZE]; /*the ring*/
+HIDDEN unsigned int traceNext; /*total records written so far (next slot is traceNext % TRACESIZE)*/
+
+#define PRINTERBUSY 3 /*printer device status: busy*/
+#endif
+
+/**************************************************************************** 
+ * traceEvent()
+ * 
+ * @brief 
+ * Appends one record to the ring. Support level code is traced with interrupts 
+ * on, so they are masked while the slot is claimed and filled.
+ * 
+ * @param type - TR_* event code
+ * @param a, b - event arguments (see TR_* in const.h)
+ * @return None
+ *****************************************************************************/
+void traceEvent(unsigned int type, unsigned int a, unsigned int b){
+#if TRACE
+    unsigned int status = getSTATUS();
+    tracerec_t *rec;
+
+    setSTATUS(status & (~IECON));
+    rec = &traceRing[traceNext % TRACESIZE];
+    traceNext++;
+    STCK(rec->t_tod);
+    rec->t_type = type;
+    rec->t_a = a;
+    rec->t_b = b;
+    setSTATUS(status);
+#endif
+}
+
+#if TRACE
+/*Print one character on the trace printer by polling it; FALSE if the printer is not there*/
+HIDDEN int tracePutChar(device_t *printer, char c){
+    if (printer->d_status != READY){
+        return FALSE;
+    }
+    printer->d_data0 = (unsigned int) c;
+    printer->d_command = PRINTCHR;
+    while (printer->d_status == PRINTERBUSY)
+        ;
+    printer->d_command = ACK; /*acknowledge the interrupt the printer raised*/
+    return TRUE;
+}
+
+/*Print val as 8 hex digits followed by sep*/
+HIDDEN int tracePutHex(device_t *printer, unsigned int val, char sep){
+    int shift;
+    for (shift = 28; shift >= 0; shift -= 4){
+        if (!tracePutChar(printer, "0123456789abcdef"[(val >> shift) & 0xF])){
+            return FALSE;
+        }
+    }
+    return tracePutChar(printer, sep);
+}
+#endif
+
+/**************************************************************************** 
+ * traceDump()
+ * 
+ * @brief 
+ * Writes the whole ring, oldest record first, to printer TRACEPRINTER. 
+ * Gives up silently if that printer is not installed.
+ * 
+ * @param None
+ * @return None
+ *****************************************************************************/
+void traceDump(){
+#if TRACE
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    device_t *printer = &(busRegArea->devreg[((PRNTINT - OFFSET) * DEVPERINT) + TRACEPRINTER]);
+    unsigned int first = (traceNext > TRACESIZE) ? (traceNext - TRACESIZE) : 0; /*oldest record still in the ring*/
+    unsigned int i;
+    tracerec_t *rec;
+
+    setSTATUS(getSTATUS() & (~IECON));
+    if (!tracePutChar(printer, 'T') || !tracePutChar(printer, ' ')
+        || !tracePutHex(printer, traceNext - first, ' ') || !tracePutHex(printer, first, '\n')){
+        return;
+    }
+    for (i = first; i < traceNext; i++){
+        rec = &traceRing[i % TRACESIZE];
+        if (!tracePutHex(printer, rec->t_tod, ' ') || !tracePutHex(printer, rec->t_type, ' ')
+            || !tracePutHex(printer, rec->t_a, ' ') || !tracePutHex(printer, rec->t_b, '\n')){
+            return;
+        }
+    }
+#endif
+}
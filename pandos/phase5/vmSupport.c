@@ -32,11 +32,87 @@
 #include "../h/initProc.h"
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"  
+#include "../h/trace.h"
+#include "../h/pageRepl.h"
+#include "../h/pageCleaner.h"
+#include "../h/swapSpace.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /*Data structures and Variables Declaration*/
 int semaphore_swapPool;              /*swap pool sempahore*/
-swap_pool_t swap_pool[SWAP_POOL_CAP];    /*swap pool table*/
+swap_pool_t *swap_pool;              /*swap pool table, swapPoolCap entries*/
+int swapPoolCap;                     /*number of swap pool frames, sized at boot by initSwapStructs()*/
+HIDDEN memaddr swapHighBase;         /*first frame above the kernel pools (frames SWAP_POOL_CAP and up)*/
+HIDDEN swap_pool_t bootSwapPool[SWAP_POOL_CAP]; /*table used when there is no RAM to spare above the kernel pools*/
+vmstats_t vmStats;                   /*pager counters, reported by test() when the u-procs are done*/
+HIDDEN unsigned int raNext[MAXUPROCS + 1]; /*per asid: page after the last one loaded (a fault there is sequential)*/
+HIDDEN int raWindow[MAXUPROCS + 1];        /*per asid: current read-ahead window, 0..READAHEAD*/
+
+/**************************************************************************************************
+ * @brief Sizes the swap pool at boot. Besides the SWAP_POOL_CAP frames at POOLBASEADDR (below the
+ * DMA buffers), the pool takes all the RAM between the end of the Nucleus' kernel pools
+ * (kernPoolEnd) and the kernel stacks KERNSTACKPAGES below RAMTOP: the swap pool table is carved
+ * first, then as many frames as fit after it.
+ *
+ * @param: None
+ * @return: None (sets swap_pool, swapPoolCap, swapHighBase; reported through debug_fxn)
+ **************************************************************************************************/
+HIDDEN void size_swap_pool(){
+    devregarea_t *busRegArea = (devregarea_t *) RAMBASEADDR;
+    memaddr stackFloor = busRegArea->rambase + busRegArea->ramsize - (KERNSTACKPAGES * PAGESIZE);
+    unsigned int freePages = (stackFloor > kernPoolEnd) ? (stackFloor - kernPoolEnd) / PAGESIZE : 0;
+    unsigned int tablePages;
+    int extra;
+
+    /*Each extra frame costs a page plus its table entry; shrink until table and frames fit*/
+    extra = (freePages * PAGESIZE) / (PAGESIZE + sizeof(swap_pool_t));
+    tablePages = 0;
+    while (extra > 0){
+        tablePages = (((SWAP_POOL_CAP + extra) * sizeof(swap_pool_t)) + PAGESIZE - 1) / PAGESIZE;
+        if (tablePages + extra <= freePages){
+            break;
+        }
+        extra--;
+    }
+
+    if (extra > 0){
+        swap_pool = (swap_pool_t *) kernPoolEnd;
+        swapHighBase = kernPoolEnd + (tablePages * PAGESIZE);
+    }
+    else{ /*no RAM to spare: the static table and the frames at POOLBASEADDR only*/
+        extra = 0;
+        swap_pool = bootSwapPool;
+        swapHighBase = stackFloor;
+    }
+    swapPoolCap = SWAP_POOL_CAP + extra;
+    debug_fxn(DBG_SWAPCAP, swapPoolCap, SWAP_POOL_CAP, extra); /*report the chosen capacity*/
+}
+
+/**************************************************************************************************
+ * @brief Physical address of a swap pool frame: the first SWAP_POOL_CAP frames are at POOLBASEADDR,
+ * the others above the kernel pools
+ **************************************************************************************************/
+memaddr swap_frame_addr(int frame){
+    if (frame < SWAP_POOL_CAP){
+        return POOLBASEADDR + (frame * PAGESIZE);
+    }
+    return swapHighBase + ((frame - SWAP_POOL_CAP) * PAGESIZE);
+}
+
+/**************************************************************************************************
+ * @brief Swap pool frame at a physical address (the inverse of swap_frame_addr())
+ *
+ * @return: the frame index, or FREE if pfn is not a swap pool frame
+ **************************************************************************************************/
+HIDDEN int swap_frame_of(memaddr pfn){
+    if (pfn >= POOLBASEADDR && pfn < POOLBASEADDR + (SWAP_POOL_CAP * PAGESIZE)){
+        return (pfn - POOLBASEADDR) / PAGESIZE;
+    }
+    if (pfn >= swapHighBase && pfn < swapHighBase + ((swapPoolCap - SWAP_POOL_CAP) * PAGESIZE)){
+        return SWAP_POOL_CAP + ((pfn - swapHighBase) / PAGESIZE);
+    }
+    return FREE;
+}
 
 /**************************************************************************************************
  * @brief Initializes the Swap Pool Table, Swap Pool Semaphore and Device Semaphores
@@ -51,47 +127,175 @@ void initSwapStructs(){
     /*Initialize swap pool semaphore*/
     semaphore_swapPool = SWAP_SEMAPHORE_INIT; /*initialize swap pool semaphore to 1*/
 
+    /*Size the swap pool from the installed RAM, set up the swap areas on the flash devices*/
+    size_swap_pool();
+    swap_init();
+
     /*Initialize the swap pool table*/
     int i;
-    for (i=0; i < SWAP_POOL_CAP; i++){
+    for (i=0; i < swapPoolCap; i++){
         swap_pool[i].asid = FREE; /*init swap pool frames as unoccupied (-1)*/
+        swap_pool[i].busy = FALSE;
+        swap_pool[i].dying = FALSE;
+        swap_pool[i].waiters = 0;
+        swap_pool[i].sema4 = 0;
+        swap_pool[i].reclaimSeq = 0;
+    }
+    repl_init(); /*reset the page replacement policy*/
+    vmStats.vm_faults = 0;
+    vmStats.vm_refaults = 0;
+    vmStats.vm_evictions = 0;
+    vmStats.vm_writebacks = 0;
+    vmStats.vm_cleaned = 0;
+    vmStats.vm_readahead = 0;
+    vmStats.vm_reclaims = 0;
+    vmStats.vm_zerofills = 0;
+    vmStats.vm_fastFaults = 0;
+    vmStats.vm_fastTime = 0;
+    vmStats.vm_slowSoft = 0;
+    vmStats.vm_slowSoftTime = 0;
+    for (i=0; i <= MAXUPROCS; i++){
+        raNext[i] = 0;
+        raWindow[i] = 0;
+        vmStats.vm_asidFaults[i] = 0;
+        vmStats.vm_asidSoft[i] = 0;
+    }
+    for (i=0; i < DEV_UNITS; i++){
+        vmStats.vm_swapDev[i] = 0;
+    }
+    vmStats.vm_latMax = 0;
+    for (i=0; i < VMLATBUCKETS; i++){
+        vmStats.vm_latHist[i] = 0;
     }
 
     /*Initialize associated semaphores*/
     int j;
     for (j=0; j < DEVICE_TYPES * DEV_UNITS; j++){
         devSema4_support[j] = SUPP_SEMA4_INIT; /*initialize device semaphores to 1*/
+        devHolder[j] = FREE;
     }
 }
 
 /**************************************************************************************************
- * @brief Implements a simple Round Robin page replacement algorithm for the swap pool. As we cycle
- * through frames, we check to see if it's occupied or not to replace the number of write-backs to
- * flash devices
+ * @brief Picks the swap pool frame for the next page in. Free frames are used first; otherwise
+ * the victim is chosen by the page replacement policy selected at build time, within the frame
+ * quotas of the faulting u-proc (pageRepl.c)
  *
- * @param: None
+ * @param: asid - u-proc the page belongs to
  * @return: integer index of next frame in swap pool to be used for page replacement
  * 
  * @ref
  * pandOS - section 4.5.4 & 4.10
  **************************************************************************************************/
-int find_frame_swapPool(){
-    static int last_replaced_idx = 0; /*last index of page swapped*/
-    int iterator = 0; 
+int find_frame_swapPool(int asid){
+    return repl_victim(asid);
+}
+
+/**************************************************************************************************
+ * @brief Gives back the swap pool frames and swap slots of a terminating u-proc, so they are reused
+ * before any live page is evicted. A frame in transit (another u-proc's Pager or the page cleaner
+ * is writing it back) is only marked dying: whoever finishes the write frees it and the swap slot
+ * it went to with frame_reap(), as that slot could otherwise be handed to another page while it is
+ * written. Its ownerEntry points into the support structure about to be deallocated, so nothing
+ * touches it after this
+ *
+ * @param: asid - the terminating u-proc
+ * @return: None
+ **************************************************************************************************/
+void swap_release_asid(int asid){
+    int i;
+    int inTransit[PAGE_TABLE_MAX + 1];
+
+    SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+    for (i = 0; i <= PAGE_TABLE_MAX; i++){
+        inTransit[i] = FALSE;
+    }
+    for (i = 0; i < swapPoolCap; i++){
+        if (swap_pool[i].asid == asid && !swap_pool[i].busy){
+            repl_assign(i, FREE);
+        }
+        else if (swap_pool[i].asid == asid){
+            swap_pool[i].dying = TRUE;
+            inTransit[swap_pool[i].pg_number] = TRUE;
+        }
+    }
+    for (i = 0; i <= PAGE_TABLE_MAX; i++){
+        if (!inTransit[i]){
+            swap_free_page(asid, i);
+        }
+    }
+    SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+}
+
+/**************************************************************************************************
+ * @brief Per-frame transit state. A frame is busy while a page is written out of it or read into
+ * it; the swap pool semaphore is not held during that I/O, only while the table is updated. A busy
+ * frame is never picked as a victim, cleaned or sampled, and a fault on the page a busy frame names
+ * waits on that frame (frame_wait) instead of on the whole pool.
+ * 
+ * frame_wait: called with the swap pool semaphore held, returns with it released once the frame
+ *             has been woken up (the caller re-acquires it and looks again)
+ * frame_wakeup: wakes the waiters of a frame (its page changed or it left transit)
+ * frame_release: ends the transit of a frame and wakes its waiters
+ * frame_reap: called when the I/O of a frame is over; if its owner terminated meanwhile (dying),
+ *             frees the frame and the swap slot of its page and returns TRUE
+ **************************************************************************************************/
+HIDDEN void frame_wait(int frame){
+    swap_pool[frame].waiters++;
+    SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+    SYSCALL(SYS3,(int)&swap_pool[frame].sema4,0,0);
+}
+
+HIDDEN void frame_wakeup(int frame){
+    while (swap_pool[frame].waiters > 0){
+        swap_pool[frame].waiters--;
+        SYSCALL(SYS4,(int)&swap_pool[frame].sema4,0,0);
+    }
+}
+
+void frame_release(int frame){
+    swap_pool[frame].busy = FALSE;
+    frame_wakeup(frame);
+}
 
-    /*Search the swap table starting from last_replaced_idx for a free page*/
-    while (iterator < SWAP_POOL_CAP && swap_pool[(last_replaced_idx + iterator) % SWAP_POOL_CAP].asid != FREE){
-        iterator++;
+int frame_reap(int frame){
+    if (!swap_pool[frame].dying){
+        return FALSE;
     }
+    swap_free_page(swap_pool[frame].asid, swap_pool[frame].pg_number);
+    repl_assign(frame, FREE);
+    swap_pool[frame].dying = FALSE;
+    return TRUE;
+}
 
-    /*If no free swap frame was found, set iterator to 1 to evict the next immediate page (unfortunate)*/
-    if (iterator == SWAP_POOL_CAP) {
-        iterator = 1;
+/**************************************************************************************************
+ * @brief Checks whether the missing page is in fact still resident: reference sampling clears the
+ * V bit of resident pages but leaves the PFN, so the page is resident if its PFN names a swap pool
+ * frame that still holds this very page
+ *
+ * @param: asid, page_no - the faulting page; ptEntry - its page table entry
+ * @return: index of the frame holding the page, or FREE if it has to be read from flash
+ **************************************************************************************************/
+HIDDEN int resident_frame(int asid, unsigned int page_no, pte_entry_t *ptEntry){
+    unsigned int pfn = ptEntry->entryLO & PFN_MASK;
+    int frame;
+
+    frame = swap_frame_of(pfn);
+    if (frame != FREE && swap_pool[frame].asid == asid && swap_pool[frame].pg_number == page_no){
+        return frame;
     }
+    return FREE;
+}
 
-    /*Update and return the new replacement index*/
-    last_replaced_idx = (last_replaced_idx + iterator) % SWAP_POOL_CAP;
-    return last_replaced_idx;
+/**************************************************************************************************
+ * @brief First store to a clean resident page: marks it dirty in the swap pool table, write-enables
+ * it in its page table entry and in the TLB. A zero-fill page stops being one: its contents go to
+ * flash from now on. Interrupts must be disabled
+ **************************************************************************************************/
+HIDDEN void mark_dirty(int frame, pte_entry_t *ptEntry){
+    swap_pool[frame].dirty = TRUE;
+    ptEntry->entryLO = (ptEntry->entryLO | D_BIT_SET) & ~ZEROFILL_BIT;
+    update_tlb_handler(ptEntry);
 }
 
 /**************************************************************************************************
@@ -125,14 +329,30 @@ int find_frame_swapPool(){
  *  pops   - section 5.4
  **************************************************************************************************/
 void flash_read_write(int deviceNum, int block_num, int op_type, int frame_dest) {
+    /*Retrieve the current process support structure*/
+    support_t *currSuppStruct = (support_t*) SYSCALL(SYS8,0,0,0); 
+
+    /*If operation failed (check device status) -> program trap handler*/
+    if (flash_io(deviceNum, block_num, op_type, frame_dest) != READY){
+        syslvl_prgmTrap_handler(currSuppStruct);
+    }
+}
+
+/**************************************************************************************************
+ * @brief
+ *  Performs the flash device operation for flash_read_write() (steps 2-7) and returns the device
+ *  status instead of trapping, so that the page cleaner daemon (which has no support structure)
+ *  can use it too
+ *
+ * @params: same as flash_read_write()
+ * @return: device status after the operation (READY on success)
+ **************************************************************************************************/
+unsigned int flash_io(int deviceNum, int block_num, int op_type, int frame_dest) {
     /*Local variables to thid method*/
     unsigned int device_status; /*Status returned by the flash device after the operation*/
     unsigned int command;       /*command to write to COMMAND field of flash device*/
     device_t* f_device;      /*pointer to the flash device reg*/
 
-    /*Retrieve the current process support structure*/
-    support_t *currSuppStruct = (support_t*) SYSCALL(SYS8,0,0,0); 
-
     /*Calculate address of specific flash device register block*/
     int devIdx = (FLASHINT-DISKINT) * DEVPERINT + deviceNum;
     SYSCALL(SYS3, (memaddr)&devSema4_support[(DEV_UNITS) + deviceNum], 0, 0); /*Perform SYS3 to lock flash device semaphore*/
@@ -158,10 +378,7 @@ void flash_read_write(int deviceNum, int block_num, int op_type, int frame_dest)
     
     /*Perform SYS4 to unlock flash device semaphore*/
     SYSCALL(SYS4, (memaddr)&devSema4_support[(DEV_UNITS) + deviceNum], 0, 0);
-    /*If operation failed (check device status) -> program trap handler*/
-    if (device_status != READY){
-        syslvl_prgmTrap_handler(currSuppStruct);
-    }
+    return device_status;
 }
 
 /**************************************************************************************************
@@ -236,6 +453,298 @@ void uTLB_RefillHandler() {
     LDST(saved_except_state);
 }
 
+/**************************************************************************************************
+ * @brief Nucleus fast path for soft page faults. Called by the Nucleus' TLB exception handler
+ * (tlbTrapHanlder) before passing a TLB exception up: if the page is still in its frame and only
+ * its page table entry and the TLB need fixing, it is fixed here, saving the pass up, the SYS8 and
+ * the SYS3/SYS4 pair of the Pager:
+ *      - TLB-invalid on a page whose V bit was cleared for reference sampling, or that is on the
+ *        reclaim list: mapped again (repl_remap())
+ *      - TLB-Modification: marked dirty, unless that would leave the page cleaner to be woken up
+ * 
+ * @details
+ * The Nucleus runs with interrupts disabled, so while the swap pool semaphore is free nobody is in
+ * the middle of a table update and the fast path may act as if it held it. When the semaphore is
+ * taken, the frame is in transit, or the page has to be read, the fault is passed up as before.
+ * Reference sampling (repl_sample()) is left to the Pager's next fault.
+ * 
+ * @param: supp - support structure of the current process
+ * @return: TRUE if the fault was resolved (the caller LDSTs the saved state), FALSE to pass it up
+ **************************************************************************************************/
+int tlb_fast_path(support_t *supp){
+    state_PTR saved_except_state = (state_PTR) BIOSDATAPAGE;
+    unsigned int exception_cause;
+    unsigned int page_no;
+    pte_entry_t *ptEntry;
+    int frame;
+    cpu_t now;
+
+    if (semaphore_swapPool <= 0){ /*a table update is in progress*/
+        return FALSE;
+    }
+    exception_cause = (saved_except_state->s_cause & GETEXCPCODE) >> CAUSESHIFT;
+    page_no = ((saved_except_state->s_entryHI & VPN_MASK) >> SHIFT_VPN) % 32;
+    ptEntry = &(supp->sup_privatePgTbl[page_no]);
+    frame = resident_frame(supp->sup_asid, page_no, ptEntry);
+    if (frame == FREE || swap_pool[frame].busy){
+        return FALSE;
+    }
+
+    if (exception_cause == TLBMODEXC){
+        if (swap_pool[frame].reclaimSeq != 0 || cleaner_wanted()){
+            return FALSE;
+        }
+        mark_dirty(frame, ptEntry);
+    }
+    else{
+        TRACE_EVENT(TR_FASTFAULT, supp->sup_asid, page_no);
+        if (swap_pool[frame].reclaimSeq != 0){
+            vmStats.vm_reclaims++;
+        }
+        else{
+            vmStats.vm_refaults++;
+        }
+        vmStats.vm_asidSoft[supp->sup_asid]++;
+        repl_remap(frame);
+    }
+
+    STCK(now);
+    vmStats.vm_fastFaults++;
+    vmStats.vm_fastTime += now - supp->sup_faultTOD;
+    return TRUE;
+}
+
+#if READAHEAD
+/**************************************************************************************************
+ * @brief Writes a page table entry into the TLB: rewrites the cached entry if there is one
+ * (TLBWI), otherwise installs it in a random slot (TLBWR). Called with interrupts disabled
+ **************************************************************************************************/
+HIDDEN void tlb_install(pte_entry_t *ptEntry){
+    setENTRYHI(ptEntry->entryHI);
+    TLBP();
+    setENTRYLO(ptEntry->entryLO);
+    if ((P_BIT_MASK & getINDEX()) == 0){
+        TLBWI();
+    }
+    else{
+        TLBWR();
+    }
+}
+
+/**************************************************************************************************
+ * @brief Sequential read-ahead after a hard fault on page_no: also loads the next pages of the
+ * u-proc, so that a linear scan takes one fault per window instead of one per page.
+ * 
+ * @details
+ * The window is adaptive, per u-proc: a fault on the page right after the last one loaded (by a
+ * fault or by read-ahead) doubles it up to READAHEAD, any other fault halves it. Pages are only
+ * loaded into free or clean frames (repl_clean_victim()), never at the cost of a write-back or
+ * beyond the u-proc's quota (repl_may_grow()), and
+ * get valid, clean PTEs and TLB entries like the faulting page. Read-ahead stops at the first
+ * frame it cannot get, at the stack page, at a zero-fill page or at a flash error (past the end of
+ * the flash image).
+ * Called with the swap pool semaphore held; like the Pager, it releases it during each read.
+ * 
+ * @param: currProc_supp_struct - faulting u-proc; page_no - its missing page (0-30);
+ *         loaded_frame - frame the missing page was just loaded into (never reused here)
+ * @return: None
+ **************************************************************************************************/
+HIDDEN void read_ahead(support_t *currProc_supp_struct, unsigned int page_no, int loaded_frame){
+    int asid = currProc_supp_struct->sup_asid;
+    unsigned int p;
+    int frame;
+    unsigned int frame_addr;
+    unsigned int status;
+    int loc;
+    pte_entry_t *ptEntry;
+
+    /*Adapt the window: sequential faults grow it, random ones shrink it*/
+    if (page_no == raNext[asid]){
+        raWindow[asid] = (raWindow[asid] == 0) ? 1 : raWindow[asid] * 2;
+        if (raWindow[asid] > READAHEAD){
+            raWindow[asid] = READAHEAD;
+        }
+    }
+    else{
+        raWindow[asid] /= 2;
+    }
+    raNext[asid] = page_no + 1;
+
+    for (p = page_no + 1; p <= page_no + raWindow[asid] && p < PAGE_TABLE_MAX && repl_may_grow(asid); p++){
+        ptEntry = &(currProc_supp_struct->sup_privatePgTbl[p]);
+        frame = resident_frame(asid, p, ptEntry);
+        if ((ptEntry->entryLO & V_BIT_SET) || frame != FREE){
+            if (frame != FREE && swap_pool[frame].reclaimSeq != 0 && !swap_pool[frame].busy){
+                repl_reclaim(frame); /*still on the reclaim list: map it again rather than let it go*/
+            }
+            raNext[asid] = p + 1; /*already resident*/
+            continue;
+        }
+
+        if (ptEntry->entryLO & ZEROFILL_BIT){ /*past the end of the image: nothing to read*/
+            return;
+        }
+
+        frame = repl_clean_victim(asid);
+        if (frame == FREE || frame == loaded_frame){
+            return;
+        }
+        frame_addr = swap_frame_addr(frame);
+
+        /*Evict the clean page in the frame (no write-back needed) and hand the frame, in transit, to page p*/
+        swap_pool[frame].busy = TRUE;
+        setSTATUS(NO_INTS);
+        if (swap_pool[frame].asid != FREE){
+            TRACE_EVENT(TR_EVICT, swap_pool[frame].asid, swap_pool[frame].pg_number);
+            vmStats.vm_evictions++;
+            swap_pool[frame].ownerEntry->entryLO &= VALIDOFF;
+            update_tlb_handler(swap_pool[frame].ownerEntry);
+        }
+        repl_assign(frame, asid);
+        swap_pool[frame].pg_number = p;
+        swap_pool[frame].ownerEntry = ptEntry;
+        swap_pool[frame].dirty = FALSE;
+        ptEntry->entryLO = frame_addr; /*PFN only: V off until the read completes*/
+        setSTATUS(YES_INTS);
+        frame_wakeup(frame);
+
+        /*Read without holding the swap pool, as the Pager does*/
+        loc = swap_locate(asid, p);
+        SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+        status = flash_io(SWAPLOC_DEV(loc), SWAPLOC_BLOCK(loc), FLASHREAD, frame_addr);
+        SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+
+        if (status != READY){ /*the frame goes back to the free pool*/
+            repl_assign(frame, FREE);
+            ptEntry->entryLO = ALLOFF;
+            frame_release(frame);
+            return;
+        }
+
+        setSTATUS(NO_INTS);
+        repl_loaded(frame);
+        ptEntry->entryLO = frame_addr | V_BIT_SET; /*valid and clean, like the faulting page*/
+        tlb_install(ptEntry);
+        setSTATUS(YES_INTS);
+        frame_release(frame);
+
+        vmStats.vm_readahead++;
+        raNext[asid] = p + 1;
+    }
+}
+#endif
+
+#if ZEROFILL
+/**************************************************************************************************
+ * @brief Marks the pages of a u-proc that lie past the end of its flash image (.text and .data as
+ * given by the .aout header, in the first words of page 0) as zero-fill: .bss pages that hold no
+ * initialized data and the unused pages up to the stack. Called by the Pager whenever page 0 has
+ * just been read; only pages never touched (entryLO still ALLOFF) are marked, so a page that was
+ * written and then evicted keeps its flash copy however often the header is read
+ *
+ * @param: currProc_supp_struct - the u-proc; frame_addr - frame page 0 was read into
+ * @return: None
+ **************************************************************************************************/
+HIDDEN void mark_zero_fill(support_t *currProc_supp_struct, unsigned int frame_addr){
+    unsigned int *header = (unsigned int *) frame_addr;
+    unsigned int imageEnd;
+    unsigned int p;
+
+    imageEnd = header[AOUT_TEXT_OFFSET] + header[AOUT_TEXT_FILESZ];
+    if (header[AOUT_DATA_OFFSET] + header[AOUT_DATA_FILESZ] > imageEnd){
+        imageEnd = header[AOUT_DATA_OFFSET] + header[AOUT_DATA_FILESZ];
+    }
+    /*The first page holding no byte of the image, rounded up: a page with the tail of .data is still read*/
+    for (p = (imageEnd + PAGESIZE - 1) / PAGESIZE; p < PAGE_TABLE_MAX; p++){
+        if (currProc_supp_struct->sup_privatePgTbl[p].entryLO == ALLOFF){
+            currProc_supp_struct->sup_privatePgTbl[p].entryLO = ZEROFILL_BIT;
+        }
+    }
+}
+
+/**************************************************************************************************
+ * @brief Fills a swap pool frame with zeroes (first touch of a zero-fill page)
+ **************************************************************************************************/
+HIDDEN void zero_frame(unsigned int frame_addr){
+    unsigned int *word = (unsigned int *) frame_addr;
+    int i;
+
+    for (i = 0; i < PAGESIZE / WORDLEN; i++){
+        word[i] = 0;
+    }
+}
+#endif
+
+/**************************************************************************************************
+ * @brief Records the service time of a soft fault resolved by the Pager (from the Nucleus' TLB
+ * exception entry, as for the fast path, to just before the LDST)
+ **************************************************************************************************/
+HIDDEN void note_slow_soft(support_t *currProc_supp_struct){
+    cpu_t now;
+
+    STCK(now);
+    vmStats.vm_slowSoft++;
+    vmStats.vm_slowSoftTime += now - currProc_supp_struct->sup_faultTOD;
+}
+
+/**************************************************************************************************
+ * @brief Records the service time of a hard page fault (from entering the Pager to just before the
+ * LDST) in the fault latency histogram
+ **************************************************************************************************/
+HIDDEN void note_fault_latency(cpu_t start){
+    cpu_t now;
+    int bucket = 0;
+
+    STCK(now);
+    if (now - start > vmStats.vm_latMax){
+        vmStats.vm_latMax = now - start;
+    }
+    while (bucket < VMLATBUCKETS - 1 && (now - start) >= ((cpu_t) VMLATUNIT << bucket)){
+        bucket++;
+    }
+    vmStats.vm_latHist[bucket]++;
+}
+
+/**************************************************************************************************
+ * @brief
+ * Handles a TLB-Modification exception: pages are mapped clean (D bit off, so write-protected) and
+ * the first store to a resident page lands here. The page is marked dirty in its page table entry
+ * (write-enabling it), in the TLB and in the swap pool table, so only written pages cost a flash
+ * write when they are evicted (mark_dirty()). Such stores are normally resolved by the Nucleus
+ * fast path (tlb_fast_path()); they get here when it could not take the swap pool or the page
+ * cleaner has to be woken up.
+ * 
+ * @param: currProc_supp_struct - support structure of the faulting process
+ * @return: None (returns control to the faulting store)
+ * 
+ * @note
+ * The page may have been evicted between the store and gaining the swap pool mutex; the store is
+ * then simply retried and takes a regular page fault.
+ **************************************************************************************************/
+HIDDEN void tlb_mod_handler(support_t *currProc_supp_struct) {
+    unsigned int page_no;
+    int frame;
+    pte_entry_t *ptEntry;
+
+    SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+
+    page_no = ((currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT].s_entryHI & VPN_MASK) >> SHIFT_VPN) % 32;
+    ptEntry = &(currProc_supp_struct->sup_privatePgTbl[page_no]);
+    frame = resident_frame(currProc_supp_struct->sup_asid, page_no, ptEntry);
+    if (frame != FREE && swap_pool[frame].reclaimSeq == 0){ /*an unmapped page on the reclaim list must stay clean*/
+        setSTATUS(NO_INTS);
+        mark_dirty(frame, ptEntry);
+        setSTATUS(YES_INTS);
+        cleaner_kick(); /*one clean frame less*/
+    }
+
+    SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+    if (frame != FREE){
+        note_slow_soft(currProc_supp_struct);
+    }
+    LDST(&(currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT]));
+}
+
 /**************************************************************************************************
  * @brief
  * The TLB exception handler (or Pager) handles page faults, including page fault on load, page 
@@ -245,23 +754,32 @@ void uTLB_RefillHandler() {
  * This function performs the following steps:
  *       1.Obtain Current Process’s Support Structure (SYS8)
  *       2.Identify the cause of the TLB exception from sup_exceptState[0].Cause
- *       3.If the cause is a "Modification" exception, treat it as a program trap
+ *       3.If the cause is a "Modification" exception, mark the page dirty (tlb_mod_handler)
  *       Otherwise:
  *       4.Gain mutual exclusion over the Swap Pool Table (SYS3 - P operation)
- *       5.Determine the missing page number
- *       6.Pick a frame from the Swap Pool (determined by the page replacement algorithm)
+ *       5.Determine the missing page number; if the page is still in a frame (its V bit was only
+ *         cleared to sample references, or it is on the reclaim list) map it again and return
+ *         without I/O. If the frame
+ *         holding it is in transit, wait for that frame first
+ *       6.Pick a frame from the Swap Pool (determined by the page replacement algorithm) and mark
+ *         it in transit (busy)
  *       7.Check if the frame is occupied by another process’s page
  *       8.If occupied, perform the following steps:
  *           - Mark the old page as invalid in the previous process’s Page Table.
  *           - Update the TLB, ensuring it reflects the invalidated page.
- *           - Write the old page back to its backing store (write to flash device)
- *       9.Load the missing page from the backing store into the selected frame
- *       10.Update the Swap Pool Table to reflect the new contents
- *       11.Update the Page Table for the new process, marking the page as valid (V bit)
- *       12.Update the TLB to include the new page
- *       13.Release mutual exclusion over the Swap Pool Table (SYS4 - V operation)
+ *           - Write the old page back to its backing store (write to flash device) if it is dirty,
+ *             with the Swap Pool Table unlocked
+ *       9.Update the Swap Pool Table to reflect the new contents (still in transit)
+ *       10.Load the missing page from the backing store into the selected frame, with the Swap
+ *          Pool Table unlocked, or zero the frame if the page is not in the flash image (zero-fill)
+ *       11.Update the Page Table for the new process, marking the page as valid (V bit) and clean
+ *       12.Update the TLB to include the new page, and end the transit of the frame
+ *       13.Top up the reclaim list and release mutual exclusion over the Swap Pool Table (SYS4 - V operation)
  *       14.Retry the instruction that caused the page fault using LDST
  * 
+ * The Swap Pool semaphore only covers table updates: faults of u-procs backed by different flash
+ * devices do their I/O in parallel.
+ * 
  * @param: None
  * @return: None
  * 
@@ -280,22 +798,28 @@ void tlb_exception_handler() {
     /*--------------Declare local variables---------------------*/
     support_t* currProc_supp_struct;
     int free_frame_num = 0;
-    int flash_no;
+    int loc;
     unsigned int frame_addr;
     unsigned int exception_cause;
     int asid;
     unsigned int missing_page_no;
+    pte_entry_t *ptEntry;
+    unsigned int status;
+    unsigned int zero_fill;
+    cpu_t fault_start;
     /*----------------------------------------------------------*/
 
+    STCK(fault_start);
+
     /*Step 1: Obtain current process support structure via syscall number 8*/
     currProc_supp_struct = (support_t*) SYSCALL(SYS8,0,0,0);
 
     /*Step 2: Identify Cause of the TLB Exception from sup_exceptState field of support structure*/
     exception_cause = (currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT].s_cause & GETEXCPCODE) >> CAUSESHIFT;
 
-    /*Step 3: If the exception code is a "modification" type, treat as program trap*/
-    if (exception_cause == 1){
-        syslvl_prgmTrap_handler(currProc_supp_struct); /*support level program trap handler*/
+    /*Step 3: If the exception code is a "modification" type, it is the first store to a clean page*/
+    if (exception_cause == TLBMODEXC){
+        tlb_mod_handler(currProc_supp_struct);
     }
     else{
         /*Step 4: First, gain mutual exclusion of swap pool via SYS3*/
@@ -303,14 +827,59 @@ void tlb_exception_handler() {
 
         /*Step 5: Compute missing page number*/
         missing_page_no = (currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT].s_entryHI & VPN_MASK) >> SHIFT_VPN;
+        TRACE_EVENT(TR_PGFAULT, currProc_supp_struct->sup_asid, missing_page_no);
+        asid = currProc_supp_struct->sup_asid; /*Get process asid to map to flash device number*/
+        missing_page_no = missing_page_no % 32; /*mod to map page to range 0-31*/
+        ptEntry = &(currProc_supp_struct->sup_privatePgTbl[missing_page_no]);
+        repl_sample(); /*periodic reference sampling (Aging, WSClock)*/
+
+        /*Step 5.1: Is the page still in a frame? If that frame is in transit (our page is being written
+          back by someone else's fault, or cleaned), wait on that frame only, then look again*/
+        free_frame_num = resident_frame(asid, missing_page_no, ptEntry);
+        while (free_frame_num != FREE && swap_pool[free_frame_num].busy){
+            frame_wait(free_frame_num);
+            SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+            free_frame_num = resident_frame(asid, missing_page_no, ptEntry);
+        }
 
-        /*Step 6: Pick a VICTIM (frame from swap pool)*/
-        free_frame_num = find_frame_swapPool();
-        frame_addr = (free_frame_num * PAGESIZE) + POOLBASEADDR; /*Calculate the starting address of the frame (4KB block)*/
-        /*We get frame address by multiplying the page size with the frame number then adding the offset which is the starting address of the swap pool*/
+        /*Step 5.2: Soft fault -> the page is still in its frame, no flash I/O needed: either it was evicted but the
+          frame is not reused yet (reclaim list), or it was only unmapped to sample references*/
+        if (free_frame_num != FREE){
+            if (swap_pool[free_frame_num].reclaimSeq != 0){
+                TRACE_EVENT(TR_RECLAIM, asid, missing_page_no);
+                vmStats.vm_reclaims++;
+                repl_reclaim(free_frame_num);
+            }
+            else{
+                TRACE_EVENT(TR_REFAULT, asid, missing_page_no);
+                vmStats.vm_refaults++;
+                repl_refault(free_frame_num);
+            }
+            vmStats.vm_asidSoft[asid]++;
+            SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+            note_slow_soft(currProc_supp_struct);
+            LDST(&(currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT]));
+        }
+        zero_fill = ptEntry->entryLO & ZEROFILL_BIT; /*kept until the page is first written (a clean copy is zeroed again)*/
+        if (zero_fill){
+            TRACE_EVENT(TR_ZEROFILL, asid, missing_page_no);
+            vmStats.vm_zerofills++;
+        }
+        else{
+            vmStats.vm_faults++;
+            vmStats.vm_asidFaults[asid]++;
+        }
+
+        /*Step 6: Pick a VICTIM (frame from swap pool) and mark it in transit: from here on nobody else
+          evicts, cleans or samples it, and faults on its old or new page wait for it*/
+        free_frame_num = find_frame_swapPool(asid);
+        frame_addr = swap_frame_addr(free_frame_num); /*Calculate the starting address of the frame (4KB block)*/
+        swap_pool[free_frame_num].busy = TRUE;
 
         /*Step 7 + 8: If the frame is occupied -> need to evict it (invalidate the page occupying this frame)*/
         if (swap_pool[free_frame_num].asid != FREE){
+            TRACE_EVENT(TR_EVICT, swap_pool[free_frame_num].asid, swap_pool[free_frame_num].pg_number);
+            vmStats.vm_evictions++;
             /*Updating TLB and Swap Pool must be atomic -> DISABLE INTERRUPTS - pandOS [section 4.5.3]*/
             setSTATUS(NO_INTS);
 
@@ -323,49 +892,104 @@ void tlb_exception_handler() {
             /*ENABLE INTERRUPTS*/
             setSTATUS(YES_INTS);
 
-            unsigned int occp_pageNum = swap_pool[free_frame_num].pg_number; /*get the page number of the page occupying the frame at swap_pool[frame_number]*/
-            occp_pageNum = occp_pageNum % 32; /*mod to map page to range 0-31*/    
-            unsigned int occp_asid = swap_pool[free_frame_num].asid; /*get ASID of process whose page owns the frame at swap_pool[frame_number]*/
-            flash_no = occp_asid - 1; /*Get corresponding flash device number*/
-
             /*Step 3: Write the old page back to its backing store (flash device) - pandOS [section 4.5.1]*/
-            flash_read_write(flash_no, occp_pageNum,FLASHWRITE, frame_addr);
+            /*A clean page is identical to its flash copy, so only dirty pages are written back*/
+            if (swap_pool[free_frame_num].dirty){
+                unsigned int occp_pageNum = swap_pool[free_frame_num].pg_number % 32; /*page number of the page occupying the frame, mapped to range 0-31*/
+                loc = swap_alloc(swap_pool[free_frame_num].asid, occp_pageNum); /*swap slot on the least busy flash device (or the page's home block)*/
+                vmStats.vm_writebacks++;
+                vmStats.vm_swapDev[SWAPLOC_DEV(loc)]++;
+
+                /*The swap pool is released during the write: the frame still names the old page, so a fault on it waits for the frame*/
+                SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                status = flash_io(SWAPLOC_DEV(loc), SWAPLOC_BLOCK(loc), FLASHWRITE, frame_addr);
+                SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+
+                if (frame_reap(free_frame_num)){ /*its owner terminated during the write: the page is gone, whatever the outcome*/
+                    status = READY;
+                }
+                if (status != READY){ /*the old page is still in the frame: give it back to its owner, trap the faulting u-proc*/
+                    setSTATUS(NO_INTS);
+                    swap_pool[free_frame_num].ownerEntry->entryLO |= V_BIT_SET;
+                    update_tlb_handler(swap_pool[free_frame_num].ownerEntry);
+                    setSTATUS(YES_INTS);
+                    frame_release(free_frame_num);
+                    SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                    syslvl_prgmTrap_handler(currProc_supp_struct);
+                }
+            }
         }
         /*If frame is not occupied*/
 
-        /*Step 9:Load missing page from backing store into the selected frame*/
-
-        asid = currProc_supp_struct->sup_asid; /*Get process asid to map to flash device number*/
-        flash_no = asid - 1; /*Get flash device number associated with the process asid*/
-        missing_page_no = missing_page_no % 32; /*mod to map page to range 0-31*/
+        /*Step 9: The frame now belongs to the missing page (still in transit): record it in the Swap Pool Table and
+          point the page table entry at it, not valid yet. Wake whoever waited for the old page: they fault it back in*/
+        setSTATUS(NO_INTS);
+        repl_assign(free_frame_num, asid); /*set asid of the u-proc that now owns this frame*/
+        swap_pool[free_frame_num].pg_number = missing_page_no; /*record virtual page number that is now occupying this frame*/
+        swap_pool[free_frame_num].ownerEntry = ptEntry; /*store pointer to page table entry for this page*/
+        swap_pool[free_frame_num].dirty = FALSE; /*just read from flash*/
+        ptEntry->entryLO = frame_addr | zero_fill; /*PFN only: V off until the read completes*/
+        setSTATUS(YES_INTS);
+        frame_wakeup(free_frame_num);
 
-        /*Perform flash read operation*/
-        flash_read_write(flash_no, missing_page_no, FLASHREAD,frame_addr);
+        /*Step 10: Load missing page from backing store into the selected frame, without holding the swap pool.
+          A zero-fill page is not in the flash image: zero the frame instead, no device I/O*/
+#if ZEROFILL
+        if (zero_fill){
+            zero_frame(frame_addr);
+        }
+        else
+#endif
+        {
+            loc = swap_locate(asid, missing_page_no); /*its own flash image, or the swap slot it was last written to*/
+            SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+            status = flash_io(SWAPLOC_DEV(loc), SWAPLOC_BLOCK(loc), FLASHREAD, frame_addr);
+            SYSCALL(SYS3,(int)&semaphore_swapPool,0,0);
+
+            if (status != READY){ /*give the frame back and trap, like flash_read_write()*/
+                repl_assign(free_frame_num, FREE);
+                ptEntry->entryLO = ALLOFF;
+                frame_release(free_frame_num);
+                SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+                syslvl_prgmTrap_handler(currProc_supp_struct);
+            }
+#if ZEROFILL
+            if (missing_page_no == 0){ /*page 0 starts with the .aout header: the pages past the image need no read*/
+                mark_zero_fill(currProc_supp_struct, frame_addr);
+            }
+#endif
+        }
 
-        /*Step 10: Update the Swap Pool Table to reflect the new contents (atomic operations)*/
         /*First, we disable Interrupts by getting current status and clearing the IEc (global interrupt) bit*/
         setSTATUS(NO_INTS);
+        repl_loaded(free_frame_num);
 
-        /*Update swap pool table with new entry*/
-        swap_pool[free_frame_num].asid = asid; /*set asid of the u-proc that now owns this frame*/
-        swap_pool[free_frame_num].pg_number = missing_page_no; /*record virtual page number that is now occupying this frame*/
-        swap_pool[free_frame_num].ownerEntry = &(currProc_supp_struct->sup_privatePgTbl[missing_page_no]); /*store pointer to page table entry for this page*/
-
-        /*Step 11: Update the Page Table for the new process, marking the page as valid (V bit) & mark D bit on (ensure page is dirty)*/
-        currProc_supp_struct->sup_privatePgTbl[missing_page_no].entryLO = frame_addr | D_BIT_SET | V_BIT_SET; /*set the valid bit and dirty bit in entryLO*/
+        /*Step 11: Update the Page Table for the new process, marking the page as valid (V bit) & clean (D bit off, write-protected until the first store)*/
+        ptEntry->entryLO = frame_addr | V_BIT_SET | zero_fill; /*set the valid bit in entryLO*/
 
         /*Step 12: Update the TLB to include the new page (optimization)*/
-        update_tlb_handler(&(currProc_supp_struct->sup_privatePgTbl[missing_page_no]));
+        update_tlb_handler(ptEntry);
 
         /*TLBCLR();*/ /*old approach - erase ALL the entries in the TLB*/
 
         /*Re-enable interrupts*/
         setSTATUS(YES_INTS);
+        frame_release(free_frame_num); /*no longer in transit*/
+
+        /*Bring in the pages that follow when the u-proc is scanning sequentially*/
+#if READAHEAD
+        read_ahead(currProc_supp_struct, missing_page_no, free_frame_num);
+#endif
+
+        /*Unmap clean pages ahead of the next faults (reclaim list), and keep the page cleaner ahead of the evictions*/
+        repl_fill_reclaim();
+        cleaner_kick();
 
         /*Step 13: Perform SYS4 to release mutex on swap pool table*/
         SYSCALL(SYS4,(int)&semaphore_swapPool,0,0);
+        note_fault_latency(fault_start);
 
         /*Step 14: Return control (context switch) to the instruction that caused the page fault*/
         LDST(&(currProc_supp_struct->sup_exceptState[PGFAULTEXCEPT]));
     }
-}
\ No newline at end of file
+}
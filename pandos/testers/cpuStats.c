@@ -0,0 +1,46 @@
+/*	Test of Get CPU Stats (SYS21) */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+/* same layout as the Nucleus' cpuacct_t */
+typedef struct cpustats {
+	unsigned int user;		/* own code */
+	unsigned int sys;		/* Nucleus, serving our SYSCALLs */
+	unsigned int intr;		/* Nucleus, serving interrupts while we ran */
+	unsigned int support;	/* our support level handlers */
+} cpustats;
+
+void main() {
+	cpustats before, after;
+	unsigned int total1, total2;
+	int i;
+
+	print(WRITETERMINAL, "cpuStats test starts\n");
+	total1 = SYSCALL(GETCPUSTATS, (int) &before, 0, 0);
+
+	if (before.user + before.sys + before.intr + before.support != total1)
+		print(WRITETERMINAL, "cpuStats error: buckets do not add up\n");
+	else
+		print(WRITETERMINAL, "cpuStats ok: buckets add up\n");
+
+	for (i = 0; i < 100000; i++)
+		;				/* user time */
+	print(WRITETERMINAL, "cpuStats: some terminal output for support level time\n");
+
+	total2 = SYSCALL(GETCPUSTATS, (int) &after, 0, 0);
+
+	if (total2 <= total1)
+		print(WRITETERMINAL, "cpuStats error: total did not grow\n");
+	else if (after.user <= before.user)
+		print(WRITETERMINAL, "cpuStats error: user time did not grow\n");
+	else if (after.support <= before.support)
+		print(WRITETERMINAL, "cpuStats error: support level time did not grow\n");
+	else
+		print(WRITETERMINAL, "cpuStats ok: user and support level time grow\n");
+
+	print(WRITETERMINAL, "cpuStats completed\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,96 @@
+/* Disk scheduling benchmark: a mix of DISK_PUT and DISK_GET on random
+   sectors of disk 1. Load it on all 8 flash devices so the requests of
+   8 u-procs queue up on the disk together; it prints how long its own
+   requests took, and test() reports the disk's mean seek distance.
+   Every sector written holds its own number in the first word, so a
+   read of a sector already written can be checked whoever wrote it last. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define REQUESTS	40		/* disk requests issued */
+#define SPAN		256		/* sectors 0 .. SPAN-1 of disk 1 */
+#define BENCHDISK	1
+
+int written[SPAN];			/* TRUE once this u-proc wrote the sector */
+char line[64];
+
+/* appends the decimal digits of n to s, returns the end of s */
+char *utoa(char *s, unsigned int n) {
+	char digits[12];
+	int i = 0;
+
+	do {
+		digits[i++] = '0' + (n % 10);
+		n = n / 10;
+	} while (n > 0);
+	while (i > 0)
+		*s++ = digits[--i];
+	return s;
+}
+
+/* appends string t to s, returns the end of s */
+char *append(char *s, char *t) {
+	while (*t)
+		*s++ = *t++;
+	return s;
+}
+
+void main() {
+	unsigned int seed;
+	unsigned int start, elapsed;
+	int i;
+	int sector;
+	int dstatus;
+	int corrupt;
+	int *buffer;
+	char *s;
+
+	buffer = (int *)(SEG2 + (20 * PAGESIZE));
+
+	print(WRITETERMINAL, "diskBench starts\n");
+	for (i = 0; i < SPAN; i++)
+		written[i] = FALSE;
+	seed = SYSCALL(GET_TOD, 0, 0, 0);
+
+	corrupt = FALSE;
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for (i = 0; i < REQUESTS; i++) {
+		seed = seed * 1103515245 + 12345;	/* LCG */
+		sector = (seed >> 16) % SPAN;
+		if ((seed >> 8) & 1) {
+			*buffer = sector;
+			dstatus = SYSCALL(DISK_PUT, (int)buffer, BENCHDISK, sector);
+			written[sector] = TRUE;
+		}
+		else {
+			dstatus = SYSCALL(DISK_GET, (int)buffer, BENCHDISK, sector);
+			if (written[sector] && *buffer != sector)
+				corrupt = TRUE;
+		}
+		if (dstatus != READY) {
+			print(WRITETERMINAL, "diskBench error: disk i/o result\n");
+			SYSCALL(TERMINATE, 0, 0, 0);
+		}
+	}
+	elapsed = SYSCALL(GET_TOD, 0, 0, 0) - start;
+
+	if (corrupt)
+		print(WRITETERMINAL, "diskBench error: bad sector readback\n");
+	else
+		print(WRITETERMINAL, "diskBench ok: sector readback\n");
+
+	/* "diskBench: 40 requests in T ticks, T/40 per request" */
+	s = append(line, "diskBench: ");
+	s = utoa(s, REQUESTS);
+	s = append(s, " requests in ");
+	s = utoa(s, elapsed);
+	s = append(s, " ticks, ");
+	s = utoa(s, elapsed / REQUESTS);
+	s = append(s, " per request\n");
+	*s = '\0';
+	print(WRITETERMINAL, line);
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,85 @@
+/* Tests the disk block cache: writes a sector of disk 1, reads it back
+   REREADS times and syncs it to the disk (DISKSYNC). With the cache on
+   the reads are copies from RAM; it prints the ticks they took, and
+   test() reports the hits and misses per disk (TR_DCACHEHIT/MISS). */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define REREADS		20
+#define CACHEDISK	1
+#define CACHESECT	40
+
+char line[64];
+
+/* appends the decimal digits of n to s, returns the end of s */
+char *utoa(char *s, unsigned int n) {
+	char digits[12];
+	int i = 0;
+
+	do {
+		digits[i++] = '0' + (n % 10);
+		n = n / 10;
+	} while (n > 0);
+	while (i > 0)
+		*s++ = digits[--i];
+	return s;
+}
+
+/* appends string t to s, returns the end of s */
+char *append(char *s, char *t) {
+	while (*t)
+		*s++ = *t++;
+	return s;
+}
+
+void main() {
+	unsigned int start, elapsed;
+	int i;
+	int dstatus;
+	int corrupt;
+	int *buffer;
+	char *s;
+
+	buffer = (int *)(SEG2 + (20 * PAGESIZE));
+
+	print(WRITETERMINAL, "diskReread starts\n");
+
+	*buffer = 4242;
+	*(buffer + (PAGESIZE / sizeof(int)) - 1) = -4242;
+	dstatus = SYSCALL(DISK_PUT, (int)buffer, CACHEDISK, CACHESECT);
+	if (dstatus != READY)
+		print(WRITETERMINAL, "diskReread error: disk i/o result\n");
+
+	corrupt = FALSE;
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for (i = 0; i < REREADS; i++) {
+		*buffer = 0;
+		dstatus = SYSCALL(DISK_GET, (int)buffer, CACHEDISK, CACHESECT);
+		if (dstatus != READY || *buffer != 4242 ||
+			*(buffer + (PAGESIZE / sizeof(int)) - 1) != -4242)
+			corrupt = TRUE;
+	}
+	elapsed = SYSCALL(GET_TOD, 0, 0, 0) - start;
+
+	if (corrupt)
+		print(WRITETERMINAL, "diskReread error: bad sector readback\n");
+	else
+		print(WRITETERMINAL, "diskReread ok: sector readback\n");
+
+	s = append(line, "diskReread: ");
+	s = utoa(s, REREADS);
+	s = append(s, " reads in ");
+	s = utoa(s, elapsed);
+	s = append(s, " ticks\n");
+	*s = '\0';
+	print(WRITETERMINAL, line);
+
+	if (SYSCALL(DISKSYNC, 0, 0, 0) != READY)
+		print(WRITETERMINAL, "diskReread error: sync result\n");
+	else
+		print(WRITETERMINAL, "diskReread ok: sync result\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,50 @@
+/* Tests seek elision: writes sectors 0-63 of disk 1 in order, then reads
+   them back in order. Consecutive sectors share a cylinder, so only the
+   first access to each cylinder needs a SEEK; test() reports the seeks
+   issued and left out (TR_DISKELIDE). The data must be the same either way. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define SECTORS		64
+#define SEQDISK		1
+
+void main() {
+	int i;
+	int dstatus;
+	int corrupt;
+	int *buffer;
+
+	buffer = (int *)(SEG2 + (20 * PAGESIZE));
+
+	print(WRITETERMINAL, "diskSeq starts\n");
+
+	for (i = 0; i < SECTORS; i++) {
+		*buffer = i;
+		*(buffer + (PAGESIZE / sizeof(int)) - 1) = -i;
+		dstatus = SYSCALL(DISK_PUT, (int)buffer, SEQDISK, i);
+		if (dstatus != READY) {
+			print(WRITETERMINAL, "diskSeq error: disk i/o result\n");
+			SYSCALL(TERMINATE, 0, 0, 0);
+		}
+	}
+
+	print(WRITETERMINAL, "diskSeq ok: wrote sectors in order\n");
+
+	corrupt = FALSE;
+	for (i = 0; i < SECTORS; i++) {
+		dstatus = SYSCALL(DISK_GET, (int)buffer, SEQDISK, i);
+		if (dstatus != READY || *buffer != i ||
+			*(buffer + (PAGESIZE / sizeof(int)) - 1) != -i) {
+			print(WRITETERMINAL, "diskSeq error: bad sector readback\n");
+			corrupt = TRUE;
+			break;
+		}
+	}
+
+	if (corrupt == FALSE)
+		print(WRITETERMINAL, "diskSeq ok: sectors read back in order\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
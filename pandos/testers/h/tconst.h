@@ -31,6 +31,8 @@
 #define DELAY			18
 #define PSEMVIRT		19
 #define VSEMVIRT		20
+#define GETCPUSTATS		21
+#define DISKSYNC		22
 
 #define SEG0			0x00000000
 #define SEG1			0x40000000
@@ -0,0 +1,41 @@
+/* Tests sequential read-ahead: scans 20 pages of kuseg in order, twice.
+   With read-ahead the scans take a few faults per window instead of one
+   per page; the data must be the same either way. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define FIRSTPAGE	10
+#define LASTPAGE	29
+
+
+void main () {
+	int i;
+	int corrupt;
+
+	print(WRITETERMINAL, "seqScan starts\n");
+
+	/* write into the first and last word of pages 10-29 of kuseg, in order */
+	for (i = FIRSTPAGE; i <= LASTPAGE; i++) {
+		*(int *)(SEG2 + (i * PAGESIZE)) = i;
+		*(int *)(SEG2 + (i * PAGESIZE) + PAGESIZE - sizeof(int)) = -i;
+	}
+
+	print(WRITETERMINAL, "seqScan ok: wrote to pages of seg kuseg\n");
+
+	/* scan them again, in order, and check the words survived */
+	corrupt = FALSE;
+	for (i = FIRSTPAGE; i <= LASTPAGE; i++)
+		if (*(int *)(SEG2 + (i * PAGESIZE)) != i ||
+			*(int *)(SEG2 + (i * PAGESIZE) + PAGESIZE - sizeof(int)) != -i) {
+			print(WRITETERMINAL, "seqScan error: pager corrupted data\n");
+			corrupt = TRUE;
+			break;
+		}
+
+	if (corrupt == FALSE)
+		print(WRITETERMINAL, "seqScan ok: data survived the sequential scans\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}